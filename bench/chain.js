@@ -0,0 +1,117 @@
+// helpers shared by the nodeos benchmarks
+// the contracts and accounts are the ones deployed by migrations/5_deploy_bancor_contracts.js
+const { getEos, packMemo } = require('../test/utils');
+
+const networkContract = 'thisisbancor';
+const bancorXContract = 'bancorxoneos';
+const networkToken = 'bnt';
+const networkTokenSymbol = 'BNT';
+const testUser = 'test1';
+
+// converters deployed by the migration, each with BNT and a token reserve
+const converters = [
+    { converter: 'cnvtaa', contract: 'aa', symbol: 'TKNA', precision: 8, relay: 'tknbntaa', relaySymbol: 'BNTTKNA' },
+    { converter: 'cnvtbb', contract: 'bb', symbol: 'TKNB', precision: 8, relay: 'tknbntbb', relaySymbol: 'BNTTKNB' },
+    { converter: 'cnvtcc', contract: 'cc', symbol: 'TKNC', precision: 8, relay: 'tknbntcc', relaySymbol: 'BNTTKNC' }
+];
+
+const bntEosConverter = { converter: 'bnt2eoscnvrt', contract: 'eosio.token', symbol: 'SYS', precision: 4 };
+
+// a path of the given number of hops starting with BNT, alternating between a converter token and BNT
+// e.g. 3 hops - cnvtaa TKNA, cnvtaa BNT, cnvtbb TKNB
+const conversionPath = hops => {
+    const path = [];
+    for (let i = 0; i < hops; i++) {
+        const c = converters[Math.floor(i / 2) % converters.length];
+        path.push(i % 2 === 0 ? [c.converter, c.symbol] : [c.converter, networkTokenSymbol]);
+    }
+    return path;
+};
+
+const pathPrecision = path => {
+    const symbol = path[path.length - 1][1];
+    const token = converters.concat(bntEosConverter).find(c => c.symbol === symbol);
+    return token ? token.precision : 10;
+};
+
+// builds a conversion memo for a path, version 1 or the packed version 2
+// the minimum return is the smallest unit of the target token
+const conversionMemo = (path, destination, version, receiverMemo) => {
+    if (version === 2)
+        return packMemo(path, 1, destination, receiverMemo);
+
+    const minReturn = `0.${'0'.repeat(pathPrecision(path) - 1)}1`;
+    const memo = `1,${path.map(hop => hop.join(' ')).join(' ')},${minReturn},${destination}`;
+    return receiverMemo ? `${memo};${receiverMemo}` : memo;
+};
+
+// formats an amount of token units, e.g. (15000, 4) is 1.5000
+const formatAmount = (units, precision) => {
+    const digits = String(units).padStart(precision + 1, '0');
+    return precision ? `${digits.slice(0, -precision)}.${digits.slice(-precision)}` : digits;
+};
+
+// sends a single action and returns the transaction result with its resource usage
+const transact = async (signer, contract, action, data) => {
+    const eos = getEos(signer);
+    const started = Date.now();
+    const res = await eos.transaction({
+        actions: [{ account: contract, name: action, authorization: [{ actor: signer, permission: 'active' }], data }]
+    });
+    return {
+        res,
+        latencyMs: Date.now() - started,
+        cpuUs: res.processed.receipt.cpu_usage_us,
+        netWords: res.processed.receipt.net_usage_words
+    };
+};
+
+// returns the ram usage of each account, in bytes
+const ramUsage = async accounts => {
+    const eos = getEos(testUser);
+    const usage = {};
+    for (const account of accounts)
+        usage[account] = (await eos.getAccount(account)).ram_usage;
+    return usage;
+};
+
+// returns the ram usage changes between two ramUsage results, only the accounts that changed
+const ramDeltas = (before, after) => {
+    const deltas = {};
+    for (const account of Object.keys(before))
+        if (after[account] !== before[account])
+            deltas[account] = after[account] - before[account];
+    return deltas;
+};
+
+// extracts the contract assertion message from a failed transaction, or the error itself
+const failureReason = err => {
+    const text = typeof err === 'string' ? err : err.message || String(err);
+    try {
+        const parsed = JSON.parse(text);
+        const details = parsed.error && parsed.error.details;
+        if (details && details.length)
+            return details[0].message.replace(/^assertion failure with message: /, '');
+        if (parsed.error)
+            return parsed.error.what || parsed.error.name;
+    }
+    catch (e) {}
+    return text.split('\n')[0];
+};
+
+module.exports = {
+    networkContract,
+    bancorXContract,
+    networkToken,
+    networkTokenSymbol,
+    testUser,
+    converters,
+    bntEosConverter,
+    conversionPath,
+    conversionMemo,
+    formatAmount,
+    transact,
+    ramUsage,
+    ramDeltas,
+    failureReason
+};
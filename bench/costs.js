@@ -0,0 +1,272 @@
+/*
+    Measures the cpu, net and ram cost of the contract actions on a local nodeos,
+    with the contracts deployed by the migrations (the same setup as the tests).
+
+    npm run bench-costs -- [options]
+
+    --hops <n>              longest conversion path, 6 by default
+    --reporters <n>         largest number of reporters in a reporttx round, all the registered reporters by default
+    --runs <n>              runs of every case, 5 by default
+    --out <file>            report path, bench/costs.json by default
+    --thresholds <file>     regression thresholds, bench/thresholds.json by default
+    --write-thresholds      writes the thresholds from this run instead of checking them
+
+    The report lists every case with the min / median / max of cpu_usage_us and net_usage_words
+    from the transaction receipts and the ram usage change of the accounts involved.
+    The median cpu, max net and max ram of every case are checked against the thresholds and the
+    process exits with 1 if any of them is exceeded.
+*/
+require('babel-core/register');
+require('babel-polyfill');
+require('dotenv').config();
+
+const fs = require('fs');
+const path = require('path');
+const { getEos } = require('../test/utils');
+const {
+    networkContract, bancorXContract, networkToken, networkTokenSymbol, testUser, converters,
+    conversionPath, conversionMemo, transact, ramUsage, ramDeltas
+} = require('./chain');
+
+// thresholds written with --write-thresholds allow this much over the measured values
+const CPU_MARGIN = 1.5;
+const NET_MARGIN = 1.1;
+const RAM_MARGIN = 1.1;
+
+const parseArgs = argv => {
+    const opts = {
+        hops: 6,
+        reporters: 0,
+        runs: 5,
+        out: path.join(__dirname, 'costs.json'),
+        thresholds: path.join(__dirname, 'thresholds.json'),
+        writeThresholds: false
+    };
+    for (let i = 0; i < argv.length; i++) {
+        const value = () => argv[++i];
+        switch (argv[i]) {
+            case '--hops': opts.hops = parseInt(value()); break;
+            case '--reporters': opts.reporters = parseInt(value()); break;
+            case '--runs': opts.runs = parseInt(value()); break;
+            case '--out': opts.out = value(); break;
+            case '--thresholds': opts.thresholds = value(); break;
+            case '--write-thresholds': opts.writeThresholds = true; break;
+            default: throw new Error(`unknown option ${argv[i]}`);
+        }
+    }
+    return opts;
+};
+
+const stats = values => {
+    const sorted = values.slice().sort((a, b) => a - b);
+    return { min: sorted[0], median: sorted[Math.floor(sorted.length / 2)], max: sorted[sorted.length - 1] };
+};
+
+// unique suffixes, so repeated runs are never duplicate transactions
+let nonce = Date.now();
+const unique = () => (nonce++).toString(36);
+
+// sends a transaction and returns its cost, with the ram usage change of the given accounts
+const sample = async (accounts, send) => {
+    const before = await ramUsage(accounts);
+    const tx = await send();
+    const deltas = ramDeltas(before, await ramUsage(accounts));
+    return { cpuUs: tx.cpuUs, netWords: tx.netWords, ramBytes: Object.values(deltas).reduce((a, b) => a + b, 0), deltas };
+};
+
+class CostSuite {
+    constructor(opts) {
+        this.opts = opts;
+        this.cases = [];
+    }
+
+    // runs a case opts.runs times, each run returns the measured transaction
+    // accounts are the ones whose ram usage is tracked
+    async measure(name, accounts, run) {
+        const samples = [];
+        for (let i = 0; i < this.opts.runs; i++)
+            samples.push(await sample(accounts, () => run(i)));
+        this.add(name, samples);
+    }
+
+    add(name, samples) {
+        const entry = {
+            name,
+            runs: samples.length,
+            cpu_usage_us: stats(samples.map(s => s.cpuUs)),
+            net_usage_words: stats(samples.map(s => s.netWords)),
+            ram_bytes: stats(samples.map(s => s.ramBytes)),
+            ram_deltas: samples[samples.length - 1].deltas
+        };
+        this.cases.push(entry);
+        console.log(`${name.padEnd(36)} cpu ${String(entry.cpu_usage_us.median).padStart(6)} us   net ${String(entry.net_usage_words.max).padStart(4)} words   ram ${String(entry.ram_bytes.max).padStart(6)} bytes`);
+    }
+}
+
+const convert = (fromContract, quantity, memo) =>
+    transact(testUser, fromContract, 'transfer', { from: testUser, to: networkContract, quantity, memo });
+
+async function conversions(suite) {
+    const bnt = `1.0000000000 ${networkTokenSymbol}`;
+    for (const version of [1, 2]) {
+        for (let hops = 1; hops <= suite.opts.hops; hops++) {
+            if (version === 2 && hops !== 1 && hops !== suite.opts.hops)
+                continue;
+            const path = conversionPath(hops);
+            const accounts = [testUser, networkContract, ...new Set(path.map(hop => hop[0]))];
+            await suite.measure(`convert v${version} ${hops} hops`, accounts, () =>
+                convert(networkToken, bnt, conversionMemo(path, testUser, version, unique())));
+        }
+    }
+
+    // a conversion between two reserves against buying and selling the smart token
+    const c = converters[0];
+    const accounts = [testUser, networkContract, c.converter];
+    await suite.measure('cross reserve conversion', accounts, () =>
+        convert(networkToken, bnt, conversionMemo([[c.converter, c.symbol]], testUser, 1, unique())));
+    await suite.measure('smart token purchase', accounts, () =>
+        convert(networkToken, bnt, conversionMemo([[c.converter, c.relaySymbol]], testUser, 1, unique())));
+    await suite.measure('smart token sale', accounts, () =>
+        convert(c.relay, `0.1000000000 ${c.relaySymbol}`, conversionMemo([[c.converter, networkTokenSymbol]], testUser, 1, unique())));
+}
+
+async function xtransfers(suite) {
+    const accounts = [testUser, bancorXContract, networkToken];
+    const xtransfer = memo => transact(testUser, networkToken, 'transfer', {
+        from: testUser, to: bancorXContract, quantity: `1.0000000000 ${networkTokenSymbol}`, memo
+    });
+
+    await suite.measure('xtransfer', accounts, () => xtransfer(`1.1,eth,${unique()}`));
+    await suite.measure('xtransfer by id', accounts, () => xtransfer(`1.1,eth,${unique()},${nonce++}`));
+}
+
+async function reports(suite) {
+    const eos = getEos(bancorXContract);
+    const settings = (await eos.getTableRows({ json: true, code: bancorXContract, scope: bancorXContract, table: 'settings', limit: 1 })).rows[0];
+    const reporters = (await eos.getTableRows({ json: true, code: bancorXContract, scope: bancorXContract, table: 'reporters', limit: 100 })).rows
+        .map(row => row.reporter);
+    const maxReporters = suite.opts.reporters ? Math.min(suite.opts.reporters, reporters.length) : reporters.length;
+
+    const setMinReporters = minReporters => transact(bancorXContract, bancorXContract, 'update', {
+        min_reporters: minReporters,
+        min_limit: settings.min_limit,
+        limit_inc: settings.limit_inc,
+        max_issue_limit: settings.max_issue_limit,
+        max_destroy_limit: settings.max_destroy_limit
+    });
+
+    const report = (reporter, txId, xTransferId) => transact(reporter, bancorXContract, 'reporttx', {
+        tx_id: txId,
+        x_transfer_id: xTransferId,
+        reporter,
+        target: testUser,
+        quantity: `1.0000000000 ${networkTokenSymbol}`,
+        memo: 'bench',
+        data: 'txHash',
+        blockchain: 'eth'
+    });
+
+    // a round of k reports of the same transfer, the last one issues the tokens
+    const accounts = [testUser, bancorXContract, networkToken];
+    const round = async (k, xTransferId) => {
+        const samples = [];
+        const txId = nonce++;
+        for (let i = 0; i < k; i++)
+            samples.push(await sample(accounts, () => report(reporters[i], txId, xTransferId)));
+        return samples;
+    };
+
+    try {
+        for (let k = 1; k <= maxReporters; k++) {
+            await setMinReporters(k);
+            const samples = Array.from({ length: k }, () => []);
+            for (let run = 0; run < suite.opts.runs; run++)
+                (await round(k, 0)).forEach((sample, i) => samples[i].push(sample));
+            samples.forEach((reportSamples, i) => suite.add(`reporttx ${i + 1} of ${k} reporters`, reportSamples));
+        }
+
+        // a transfer with an id also stores its amount, which the target then sends with transferbyid
+        // the token contract clears the amount with an inline clearamount, measured as part of transferbyid
+        await setMinReporters(settings.min_reporters);
+        const idSamples = [];
+        const transferSamples = [];
+        for (let run = 0; run < suite.opts.runs; run++) {
+            const xTransferId = nonce++;
+            const samples = await round(settings.min_reporters, xTransferId);
+            idSamples.push(samples[samples.length - 1]);
+
+            transferSamples.push(await sample([testUser, reporters[0], bancorXContract, networkToken], () =>
+                transact(testUser, networkToken, 'transferbyid', {
+                    from: testUser, to: reporters[0], amount_account: bancorXContract, amount_id: xTransferId, memo: 'bench'
+                })));
+        }
+        suite.add('reporttx by id, issuing report', idSamples);
+        suite.add('transferbyid', transferSamples);
+    }
+    finally {
+        await setMinReporters(settings.min_reporters);
+    }
+}
+
+// returns the threshold violations of the report
+const checkThresholds = (cases, thresholds) => {
+    const violations = [];
+    for (const entry of cases) {
+        const limit = thresholds[entry.name];
+        if (!limit)
+            continue;
+        if (entry.cpu_usage_us.median > limit.cpu_usage_us)
+            violations.push(`${entry.name}: cpu ${entry.cpu_usage_us.median} us > ${limit.cpu_usage_us} us`);
+        if (entry.net_usage_words.max > limit.net_usage_words)
+            violations.push(`${entry.name}: net ${entry.net_usage_words.max} words > ${limit.net_usage_words} words`);
+        if (entry.ram_bytes.max > limit.ram_bytes)
+            violations.push(`${entry.name}: ram ${entry.ram_bytes.max} bytes > ${limit.ram_bytes} bytes`);
+    }
+    return violations;
+};
+
+async function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    const suite = new CostSuite(opts);
+    const info = await getEos(testUser).getInfo({});
+
+    await conversions(suite);
+    await xtransfers(suite);
+    await reports(suite);
+
+    const report = {
+        date: new Date().toISOString(),
+        server_version: info.server_version_string || info.server_version,
+        runs: opts.runs,
+        cases: suite.cases
+    };
+    fs.writeFileSync(opts.out, JSON.stringify(report, null, 2) + '\n');
+    console.log(`report written to ${opts.out}`);
+
+    if (opts.writeThresholds) {
+        const thresholds = {};
+        for (const entry of suite.cases)
+            thresholds[entry.name] = {
+                cpu_usage_us: Math.ceil(entry.cpu_usage_us.median * CPU_MARGIN),
+                net_usage_words: Math.ceil(entry.net_usage_words.max * NET_MARGIN),
+                ram_bytes: Math.max(0, Math.ceil(entry.ram_bytes.max * RAM_MARGIN))
+            };
+        fs.writeFileSync(opts.thresholds, JSON.stringify(thresholds, null, 2) + '\n');
+        console.log(`thresholds written to ${opts.thresholds}`);
+        return 0;
+    }
+
+    if (!fs.existsSync(opts.thresholds)) {
+        console.log(`no thresholds at ${opts.thresholds}, run with --write-thresholds to record them`);
+        return 0;
+    }
+
+    const violations = checkThresholds(suite.cases, JSON.parse(fs.readFileSync(opts.thresholds)));
+    violations.forEach(v => console.log(`REGRESSION ${v}`));
+    return violations.length ? 1 : 0;
+}
+
+main().then(code => process.exit(code), err => {
+    console.error(err);
+    process.exit(1);
+});
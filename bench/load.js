@@ -0,0 +1,231 @@
+/*
+    Drives concurrent conversion and cross chain transfer streams against a local nodeos,
+    with the contracts deployed by the migrations, and reports the sustained throughput.
+
+    npm run bench-load -- [options]
+
+    --duration <seconds>    how long to generate load, 60 by default
+    --streams <n>           concurrent streams, 8 by default
+    --mix <weights>         traffic mix as name:weight pairs, bnteos:4,multihop:3,xtransfer:1 by default
+                            bnteos - BNT to SYS and back through bnt2eoscnvrt
+                            multihop - BNT through a path of --hops conversions
+                            xtransfer - BNT cross chain transfers
+    --hops <n>              multihop path length, 4 by default
+    --interval <ms>         pause between the transactions of a stream, 0 by default
+    --out <file>            also writes the report as json
+
+    Every stream sends its next transaction once the previous one was pushed, so the load adapts to the
+    node. Transactions count as completed once a block includes them, the inclusion latency is
+    measured from the push until the head block reaches the block of the transaction.
+*/
+require('babel-core/register');
+require('babel-polyfill');
+require('dotenv').config();
+
+const fs = require('fs');
+const { getEos, snooze } = require('../test/utils');
+const {
+    networkContract, bancorXContract, networkToken, networkTokenSymbol, testUser, bntEosConverter,
+    conversionPath, conversionMemo, formatAmount, transact, failureReason
+} = require('./chain');
+
+const HEAD_POLL_INTERVAL = 100; // ms
+
+const parseArgs = argv => {
+    const opts = { duration: 60, streams: 8, mix: 'bnteos:4,multihop:3,xtransfer:1', hops: 4, interval: 0, out: null };
+    for (let i = 0; i < argv.length; i++) {
+        const value = () => argv[++i];
+        switch (argv[i]) {
+            case '--duration': opts.duration = parseFloat(value()); break;
+            case '--streams': opts.streams = parseInt(value()); break;
+            case '--mix': opts.mix = value(); break;
+            case '--hops': opts.hops = parseInt(value()); break;
+            case '--interval': opts.interval = parseInt(value()); break;
+            case '--out': opts.out = value(); break;
+            default: throw new Error(`unknown option ${argv[i]}`);
+        }
+    }
+    return opts;
+};
+
+const percentile = (sorted, p) => sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))] : null;
+
+let nonce = Date.now();
+const unique = () => (nonce++).toString(36);
+
+// the transactions of each traffic type, every call returns the next transaction to push
+const traffic = opts => {
+    const bnt = `0.0100000000 ${networkTokenSymbol}`;
+    const path = conversionPath(opts.hops);
+    let buyEos = false;
+
+    return {
+        // alternates between buying SYS with BNT and selling it back
+        bnteos: () => {
+            buyEos = !buyEos;
+            if (buyEos)
+                return [testUser, networkToken, 'transfer', {
+                    from: testUser, to: networkContract, quantity: bnt,
+                    memo: conversionMemo([[bntEosConverter.converter, bntEosConverter.symbol]], testUser, 1, unique())
+                }];
+            return [testUser, bntEosConverter.contract, 'transfer', {
+                from: testUser, to: networkContract, quantity: `${formatAmount(1, bntEosConverter.precision)} ${bntEosConverter.symbol}`,
+                memo: conversionMemo([[bntEosConverter.converter, networkTokenSymbol]], testUser, 1, unique())
+            }];
+        },
+        multihop: () => [testUser, networkToken, 'transfer', {
+            from: testUser, to: networkContract, quantity: bnt, memo: conversionMemo(path, testUser, 1, unique())
+        }],
+        xtransfer: () => [testUser, networkToken, 'transfer', {
+            from: testUser, to: bancorXContract, quantity: `1.0000000000 ${networkTokenSymbol}`, memo: `1.1,eth,${unique()}`
+        }]
+    };
+};
+
+// picks traffic types by weight
+const mixer = (mix, generators) => {
+    const weights = mix.split(',').map(entry => {
+        const [name, weight] = entry.split(':');
+        if (!generators[name])
+            throw new Error(`unknown traffic type ${name}`);
+        return { name, weight: parseFloat(weight || '1') };
+    });
+    const total = weights.reduce((sum, w) => sum + w.weight, 0);
+    return () => {
+        let r = Math.random() * total;
+        for (const w of weights)
+            if ((r -= w.weight) < 0)
+                return w.name;
+        return weights[weights.length - 1].name;
+    };
+};
+
+// polls the head block and resolves the waiters once it reaches their block
+class BlockWatcher {
+    constructor(eos) {
+        this.eos = eos;
+        this.head = 0;
+        this.waiters = [];
+        this.running = true;
+    }
+
+    async run() {
+        while (this.running || this.waiters.length) {
+            try {
+                this.head = (await this.eos.getInfo({})).head_block_num;
+                const now = Date.now();
+                this.waiters = this.waiters.filter(w => {
+                    if (w.block > this.head)
+                        return true;
+                    w.resolve(now);
+                    return false;
+                });
+            }
+            catch (e) {}
+            await snooze(HEAD_POLL_INTERVAL);
+        }
+    }
+
+    // resolves with the time the head block reached the block
+    included(block) {
+        return new Promise(resolve => this.waiters.push({ block, resolve }));
+    }
+
+    stop() {
+        this.running = false;
+    }
+}
+
+async function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    const generators = traffic(opts);
+    const pick = mixer(opts.mix, generators);
+    const watcher = new BlockWatcher(getEos(testUser));
+    const watching = watcher.run();
+
+    const stats = {};
+    const statsOf = type => stats[type] = stats[type] || { sent: 0, completed: 0, failures: {}, pushLatency: [], inclusionLatency: [] };
+    const inclusions = [];
+
+    const started = Date.now();
+    const deadline = started + opts.duration * 1000;
+
+    const stream = async () => {
+        while (Date.now() < deadline) {
+            const type = pick();
+            const s = statsOf(type);
+            const sent = Date.now();
+            s.sent++;
+            try {
+                const tx = await transact(...generators[type]());
+                s.pushLatency.push(tx.latencyMs);
+                // the inclusion is awaited in the background, the stream moves on to its next transaction
+                // older nodes don't return the block number, the next block is the earliest it can be in
+                const block = tx.res.processed.block_num || watcher.head + 1;
+                inclusions.push(watcher.included(block).then(time => {
+                    s.completed++;
+                    s.inclusionLatency.push(time - sent);
+                }));
+            }
+            catch (err) {
+                const reason = failureReason(err);
+                s.failures[reason] = (s.failures[reason] || 0) + 1;
+            }
+            if (opts.interval)
+                await snooze(opts.interval);
+        }
+    };
+
+    await Promise.all(Array.from({ length: opts.streams }, stream));
+    const elapsed = (Date.now() - started) / 1000;
+    await Promise.all(inclusions);
+    watcher.stop();
+    await watching;
+
+    const summarize = s => {
+        const push = s.pushLatency.slice().sort((a, b) => a - b);
+        const inclusion = s.inclusionLatency.slice().sort((a, b) => a - b);
+        return {
+            sent: s.sent,
+            completed: s.completed,
+            tps: +(s.completed / elapsed).toFixed(2),
+            failures: s.failures,
+            push_latency_ms: { p50: percentile(push, 0.5), p99: percentile(push, 0.99) },
+            inclusion_latency_ms: { p50: percentile(inclusion, 0.5), p99: percentile(inclusion, 0.99) }
+        };
+    };
+
+    const total = { sent: 0, completed: 0, failures: {}, pushLatency: [], inclusionLatency: [] };
+    for (const s of Object.values(stats)) {
+        total.sent += s.sent;
+        total.completed += s.completed;
+        total.pushLatency.push(...s.pushLatency);
+        total.inclusionLatency.push(...s.inclusionLatency);
+        for (const [reason, count] of Object.entries(s.failures))
+            total.failures[reason] = (total.failures[reason] || 0) + count;
+    }
+
+    const report = {
+        date: new Date().toISOString(),
+        duration_s: elapsed,
+        streams: opts.streams,
+        mix: opts.mix,
+        total: summarize(total),
+        by_type: Object.keys(stats).reduce((res, type) => Object.assign(res, { [type]: summarize(stats[type]) }), {})
+    };
+
+    const line = (name, r) => console.log(`${name.padEnd(10)} ${String(r.tps).padStart(8)} tx/s   ${String(r.completed).padStart(6)}/${String(r.sent).padEnd(6)} included   inclusion p50 ${r.inclusion_latency_ms.p50} ms  p99 ${r.inclusion_latency_ms.p99} ms`);
+    for (const [type, r] of Object.entries(report.by_type))
+        line(type, r);
+    line('total', report.total);
+    for (const [reason, count] of Object.entries(report.total.failures))
+        console.log(`failed ${String(count).padStart(6)}  ${reason}`);
+
+    if (opts.out)
+        fs.writeFileSync(opts.out, JSON.stringify(report, null, 2) + '\n');
+}
+
+main().then(() => process.exit(0), err => {
+    console.error(err);
+    process.exit(1);
+});
@@ -1,24 +1,9 @@
 #include "./BancorConverter.hpp"
 #include "../Common/common.hpp"
-#include <math.h>
+#include "../Common/dispatcher.hpp"
 
 using namespace eosio;
 
-struct account {
-    asset    balance;
-    uint64_t primary_key() const { return balance.symbol.code().raw(); }
-};
-
-TABLE currency_stats {
-    asset   supply;
-    asset   max_supply;
-    name    issuer;
-    uint64_t primary_key() const { return supply.symbol.code().raw(); }
-};
-
-typedef eosio::multi_index<"stat"_n, currency_stats> stats;
-typedef eosio::multi_index<"accounts"_n, account> accounts;
-
 ACTION BancorConverter::init(name smart_contract,
                              asset smart_currency,
                              bool  smart_enabled,
@@ -45,7 +30,10 @@ ACTION BancorConverter::init(name smart_contract,
     new_settings.require_balance = require_balance;
     new_settings.max_fee         = max_fee;
     new_settings.fee             = fee;
+    new_settings.smart_supply    = asset(0, smart_currency.symbol);
     settings_table.set(new_settings, _self);
+
+    update_network_registry(network);
 }
 
 ACTION BancorConverter::update(bool smart_enabled, bool enabled, bool require_balance, uint64_t fee) {
@@ -53,7 +41,7 @@ ACTION BancorConverter::update(bool smart_enabled, bool enabled, bool require_ba
     eosio_assert(fee <= 1000, "fee must be lower or equal to 1000");
 
     settings settings_table(_self, _self.value);
-    auto st = settings_table.get();
+    auto st = get_settings(_self);
     eosio_assert(fee <= st.max_fee, "fee must be lower or equal to the maximum fee");
 
     st.smart_enabled   = smart_enabled;
@@ -61,6 +49,8 @@ ACTION BancorConverter::update(bool smart_enabled, bool enabled, bool require_ba
     st.require_balance = require_balance;
     st.fee             = fee;
     settings_table.set(st, _self);
+
+    update_network_registry(st.network);
 }
 
 ACTION BancorConverter::setreserve(name contract, asset currency, uint64_t ratio, bool p_enabled) {
@@ -76,13 +66,16 @@ ACTION BancorConverter::setreserve(name contract, asset currency, uint64_t ratio
             s.currency    = currency;
             s.ratio       = ratio;
             s.p_enabled   = p_enabled;
+            if (!s.balance.has_value())
+                s.balance = asset(get_balance_amount(contract, _self, currency.symbol.code()), currency.symbol);
         });
     }
-    else reserves_table.emplace(_self, [&](auto& s) {
+    else existing = reserves_table.emplace(_self, [&](auto& s) {
         s.contract    = contract;
         s.currency    = currency;
         s.ratio       = ratio;
         s.p_enabled   = p_enabled;
+        s.balance     = asset(get_balance_amount(contract, _self, currency.symbol.code()), currency.symbol);
     });
 
     uint64_t total_ratio = 0;
@@ -91,33 +84,35 @@ ACTION BancorConverter::setreserve(name contract, asset currency, uint64_t ratio
     
     eosio_assert(total_ratio <= 1000, "total ratio cannot exceed 1000");
 
-    settings settings_table(_self, _self.value);
-    auto converter_settings = settings_table.get();
-    auto current_smart_supply = ((get_supply(converter_settings.smart_contract, converter_settings.smart_currency.symbol.code())).amount + converter_settings.smart_currency.amount) / pow(10, converter_settings.smart_currency.symbol.precision());
-    auto reserve_balance = ((get_balance_amount(contract, _self, currency.symbol.code())) + currency.amount) / pow(10, currency.symbol.precision()); 
-    EMIT_PRICE_DATA_EVENT(current_smart_supply, contract, currency.symbol.code(), reserve_balance, ratio);
+    auto converter_settings = get_settings(_self);
+    auto smart_supply_amount = converter_settings.smart_supply->amount + converter_settings.smart_currency.amount;
+    auto reserve_balance = existing->balance->amount + currency.amount;
+    EMIT_PRICE_DATA_EVENT(decimal_amount({ smart_supply_amount, converter_settings.smart_currency.symbol.precision() }), contract, currency.symbol.code(), decimal_amount({ reserve_balance, currency.symbol.precision() }), ratio);
+
+    update_network_registry(converter_settings.network);
 }
 
-void BancorConverter::convert(name from, eosio::asset quantity, std::string memo, name code) {
+void BancorConverter::convert(name from, eosio::asset quantity, const string& memo, name code) {
     eosio_assert(quantity.is_valid(), "invalid quantity");
     eosio_assert(quantity.amount != 0, "zero quantity is disallowed");
-    auto from_amount = quantity.amount / pow(10, quantity.symbol.precision());
 
     auto memo_object = parse_memo(memo);
-    eosio_assert(memo_object.path.size() > 1, "invalid memo format");
+    eosio_assert(memo_object.remaining_hops() > 0, "invalid memo format");
     settings settings_table(_self, _self.value);
-    auto converter_settings = settings_table.get();
+    auto converter_settings = get_settings(_self);
     eosio_assert(converter_settings.enabled, "converter is disabled");
-    eosio_assert(converter_settings.network == from, "converter can only receive from network contract");
+    // converters forward the return of a step directly to the converter of the next step
+    eosio_assert(converter_settings.network == from || is_network_converter(from, converter_settings.network),
+                 "converter can only receive from network contract");
 
-    auto contract_name = name(memo_object.path[0].c_str());
+    auto contract_name = memo_object.current_hop().converter_name();
     eosio_assert(contract_name == _self, "wrong converter");
-    auto from_path_currency = quantity.symbol.code().raw();
-    auto to_path_currency = symbol_code(memo_object.path[1].c_str()).raw();
+    auto from_path_currency = quantity.symbol.code();
+    auto to_path_currency = memo_object.current_hop().to_symbol_code();
     eosio_assert(from_path_currency != to_path_currency, "cannot convert to self");
-    auto smart_symbol_name = converter_settings.smart_currency.symbol.code().raw();
-    auto from_token = get_reserve(from_path_currency, converter_settings);
-    auto to_token = get_reserve(to_path_currency, converter_settings);
+    auto smart_symbol_name = converter_settings.smart_currency.symbol.code();
+    auto from_token = get_reserve(_self, from_path_currency, converter_settings);
+    auto to_token = get_reserve(_self, to_path_currency, converter_settings);
 
     auto from_currency = from_token.currency;
     auto to_currency = to_token.currency;
@@ -127,23 +122,21 @@ void BancorConverter::convert(name from, eosio::asset quantity, std::string memo
     auto from_contract = from_token.contract;
     auto to_contract = to_token.contract;
 
-    bool incoming_smart_token = (from_currency.symbol.code().raw() == smart_symbol_name);
-    bool outgoing_smart_token = (to_currency.symbol.code().raw() == smart_symbol_name);
-    
-    auto from_ratio = from_token.ratio;
-    auto to_ratio = to_token.ratio;
+    bool incoming_smart_token = (from_currency.symbol.code() == smart_symbol_name);
+    bool outgoing_smart_token = (to_currency.symbol.code() == smart_symbol_name);
 
     eosio_assert(to_token.p_enabled, "'to' token purchases disabled");
     eosio_assert(code == from_contract, "unknown 'from' contract");
-    auto current_from_balance = ((get_balance(from_contract, _self, from_currency.symbol.code())).amount + from_currency.amount - quantity.amount) / pow(10, from_currency.symbol.precision()); 
-    auto current_to_balance = ((get_balance(to_contract, _self, to_currency.symbol.code())).amount + to_currency.amount) / pow(10, to_currency_precision);
-    auto current_smart_supply = ((get_supply(converter_settings.smart_contract, converter_settings.smart_currency.symbol.code())).amount + converter_settings.smart_currency.amount) / pow(10, converter_settings.smart_currency.symbol.precision());
-
-    name final_to = name(memo_object.dest_account.c_str());
-    double smart_tokens = 0;
-    double to_tokens = 0;
-    double total_fee_amount = 0;
-    bool quick = false;
+    if (outgoing_smart_token)
+        eosio_assert(memo_object.remaining_hops() == 1, "smart token must be final currency");
+
+    // the tracked 'from' balance already includes the received quantity, see transfer
+    if (!incoming_smart_token)
+        from_token.balance->amount -= quantity.amount;
+    auto result = calculate_conversion(converter_settings, from_token, to_token, quantity.amount);
+
+    name final_to = memo_object.destination();
+    int64_t to_amount = result.to_amount;
     if (incoming_smart_token) {
         // destory received token
         action(
@@ -151,72 +144,42 @@ void BancorConverter::convert(name from, eosio::asset quantity, std::string memo
             converter_settings.smart_contract, "retire"_n,
             std::make_tuple(quantity, std::string("destroy on conversion"))
         ).send();
-
-        smart_tokens = from_amount;
-        current_smart_supply -= smart_tokens;
-    }
-    else if (!incoming_smart_token && !outgoing_smart_token && (from_ratio == to_ratio) && (converter_settings.fee == 0)) {
-        to_tokens = quick_convert(current_from_balance, from_amount, current_to_balance);
-        quick = true;
     }
-    else {
-        smart_tokens = calculate_purchase_return(current_from_balance, from_amount, current_smart_supply, from_ratio);
-        current_smart_supply += smart_tokens;
-        if (converter_settings.fee > 0) {
-            double ffee = (1.0 * converter_settings.fee / 1000.0);
-            auto fee = smart_tokens * ffee;
-            if (fee > 0) {
-                smart_tokens = smart_tokens - fee;
-                total_fee_amount += fee;
-            }
-        }
-    }
-
-    auto issue = false;
-    if (outgoing_smart_token) {
-        eosio_assert(memo_object.path.size() == 2, "smart token must be final currency");
-        to_tokens = smart_tokens;
-        issue = true;
-    }
-    else if (!quick) {
-        if (converter_settings.fee) {
-            double ffee = (1.0 * converter_settings.fee / 1000.0);
-            auto fee = smart_tokens * ffee;
-            if (fee > 0) {
-                smart_tokens = smart_tokens - fee;
-                total_fee_amount += fee;
-            }
-        }
 
-        to_tokens = calculate_sale_return(current_to_balance, smart_tokens, current_smart_supply, to_ratio);
+    if (incoming_smart_token || outgoing_smart_token) {
+        converter_settings.smart_supply->amount = result.smart_supply - converter_settings.smart_currency.amount;
+        settings_table.set(converter_settings, _self);
     }
 
-    int64_t to_amount = (to_tokens * pow(10, to_currency_precision));
-
-    double formatted_total_fee_amount = (int)(total_fee_amount * pow(10, to_currency_precision)) / pow(10, to_currency_precision);
-    EMIT_CONVERSION_EVENT(memo, from_token.contract, from_currency.symbol.code(), to_token.contract, to_currency.symbol.code(), from_amount, (to_amount / pow(10, to_currency_precision)), formatted_total_fee_amount);
+    EMIT_CONVERSION_EVENT(memo, from_token.contract, from_currency.symbol.code(), to_token.contract, to_currency.symbol.code(),
+                          decimal_amount({ quantity.amount, quantity.symbol.precision() }),
+                          decimal_amount({ to_amount, to_currency_precision }),
+                          decimal_amount({ result.fee_amount, to_currency_precision }));
 
+    auto smart_supply = decimal_amount({ result.smart_supply, converter_settings.smart_currency.symbol.precision() });
     if (incoming_smart_token || !outgoing_smart_token)
-        EMIT_PRICE_DATA_EVENT(current_smart_supply, to_token.contract, to_currency.symbol.code(), current_to_balance - to_amount, (to_ratio / 1000.0));
+        EMIT_PRICE_DATA_EVENT(smart_supply, to_token.contract, to_currency.symbol.code(), decimal_amount({ result.to_balance, to_currency_precision }), decimal_amount({ int64_t(to_token.ratio), 3 }));
     if (outgoing_smart_token || !incoming_smart_token)
-        EMIT_PRICE_DATA_EVENT(current_smart_supply, from_token.contract, from_currency.symbol.code(), current_from_balance, (from_ratio / 1000.0));
-
-    path new_path = memo_object.path;
-    new_path.erase(new_path.begin(), new_path.begin() + 2);
-    memo_object.path = new_path;
+        EMIT_PRICE_DATA_EVENT(smart_supply, from_token.contract, from_currency.symbol.code(), decimal_amount({ result.from_balance, from_currency.symbol.precision() }), decimal_amount({ int64_t(from_token.ratio), 3 }));
 
-    auto new_memo = build_memo(memo_object);
     auto new_asset = asset(to_amount, to_currency.symbol);
-    name inner_to = converter_settings.network;
-    if (memo_object.path.size() == 0) {
+    name inner_to;
+    string new_memo;
+    if (memo_object.remaining_hops() == 1) {
         inner_to = final_to;
-        verify_min_return(new_asset, memo_object.min_return);
+        verify_min_return(new_asset, memo_object);
         if (converter_settings.require_balance)
             verify_entry(inner_to, to_contract, new_asset);
-        new_memo = memo_object.receiver_memo;
+        new_memo = string(memo_object.receiver_memo);
+    }
+    else {
+        // the next converter receives the return directly rather than through the network
+        inner_to = memo_object.hops[memo_object.hop + 1].converter_name();
+        eosio_assert(inner_to != _self, "consecutive steps cannot use the same converter");
+        new_memo = next_hop(memo, memo_object);
     }
 
-    if (issue)
+    if (outgoing_smart_token)
         action(
             permission_level{ _self, "active"_n },
             to_contract, "issue"_n,
@@ -230,47 +193,29 @@ void BancorConverter::convert(name from, eosio::asset quantity, std::string memo
         ).send();
 }
 
- // returns a reserve object
- // can also be called for the smart token itself
-const BancorConverter::reserve_t& BancorConverter::get_reserve(uint64_t name, const settings_t& settings) {
-    if (settings.smart_currency.symbol.code().raw() == name) {
-        static reserve_t temp_reserve;
-        temp_reserve.ratio = 0;
-        temp_reserve.contract = settings.smart_contract;
-        temp_reserve.currency = settings.smart_currency;
-        temp_reserve.p_enabled = settings.smart_enabled;
-        return temp_reserve;
-    }
-
+// updates the tracked balance of a reserve, transfers of other tokens are ignored
+void BancorConverter::track_reserve_balance(name contract, asset delta) {
     reserves reserves_table(_self, _self.value);
-    auto existing = reserves_table.find(name);
-    eosio_assert(existing != reserves_table.end(), "reserve not found");
-    return *existing;
-}
-
-// returns the balance object for an account
-asset BancorConverter::get_balance(name contract, name owner, symbol_code sym) {
-    accounts accountstable(contract, owner.value);
-    const auto& ac = accountstable.get(sym.raw());
-    return ac.balance;
-}
-
-// returns the balance amount for an account
-uint64_t BancorConverter::get_balance_amount(name contract, name owner, symbol_code sym) {
-    accounts accountstable(contract, owner.value);
-
-    auto ac = accountstable.find(sym.raw());
-    if (ac != accountstable.end())
-        return ac->balance.amount;
+    auto reserve = reserves_table.find(delta.symbol.code().raw());
+    if (reserve == reserves_table.end() || reserve->contract != contract)
+        return;
 
-    return 0;
+    reserves_table.modify(reserve, _self, [&](auto& r) {
+        // an untracked balance is read from the token contract, which already includes the transfer
+        if (r.balance.has_value())
+            r.balance.value() += delta;
+        else
+            r.balance = asset(get_balance_amount(contract, _self, delta.symbol.code()), r.currency.symbol);
+    });
 }
 
-// returns a token supply
-asset BancorConverter::get_supply(name contract, symbol_code sym) {
-    stats statstable(contract, sym.raw());
-    const auto& st = statstable.get(sym.raw());
-    return st.supply;
+// updates the converter entry in the network registry, runs after the calling action
+void BancorConverter::update_network_registry(name network) {
+    action(
+        permission_level{ _self, "active"_n },
+        network, "regconverter"_n,
+        std::make_tuple(_self)
+    ).send();
 }
 
 // asserts if the supplied account doesn't have an entry for a given token
@@ -281,73 +226,31 @@ void BancorConverter::verify_entry(name account, name currency_contact, eosio::a
 }
 
 // asserts if a conversion resulted in an amount lower than the minimum amount defined by the caller
-void BancorConverter::verify_min_return(eosio::asset quantity, std::string min_return) {
-	float ret = stof(min_return.c_str());
-    int64_t ret_amount = (ret * pow(10, quantity.symbol.precision()));
-    eosio_assert(quantity.amount >= ret_amount, "below min return");
+void BancorConverter::verify_min_return(eosio::asset quantity, const memo_structure& memo) {
+    eosio_assert(quantity.amount >= memo.min_return_units(quantity.symbol.precision()), "below min return");
 }
 
-// given a token supply, reserve balance, ratio and a input amount (in the reserve token),
-// calculates the return for a given conversion (in the main token)
-double BancorConverter::calculate_purchase_return(double balance, double deposit_amount, double supply, int64_t ratio) {
-    double R(supply);
-    double C(balance + deposit_amount);
-    double F(ratio / 1000.0);
-    double T(deposit_amount);
-    double ONE(1.0);
-
-    double E = -R * (ONE - pow(ONE + T / C, F));
-    return E;
-}
+ACTION BancorConverter::resync() {
+    require_auth(_self);
 
-// given a token supply, reserve balance, ratio and a input amount (in the main token),
-// calculates the return for a given conversion (in the reserve token)
-double BancorConverter::calculate_sale_return(double balance, double sell_amount, double supply, int64_t ratio) {
-    double R(supply - sell_amount);
-    double C(balance);
-    double F(1000.0 / ratio);
-    double E(sell_amount);
-    double ONE(1.0);
-
-    double T = C * (pow(ONE + E/R, F) - ONE);
-    return T;
-}
+    settings settings_table(_self, _self.value);
+    auto st = settings_table.get();
+    st.smart_supply = get_supply(st.smart_contract, st.smart_currency.symbol.code());
+    settings_table.set(st, _self);
 
-double BancorConverter::quick_convert(double balance, double in, double toBalance) {
-    return in / (balance + in) * toBalance;
+    reserves reserves_table(_self, _self.value);
+    for (auto reserve = reserves_table.begin(); reserve != reserves_table.end(); ++reserve)
+        reserves_table.modify(reserve, _self, [&](auto& r) {
+            r.balance = asset(get_balance_amount(r.contract, _self, r.currency.symbol.code()), r.currency.symbol);
+        });
 }
 
-float BancorConverter::stof(const char* s) {
-    float rez = 0, fact = 1;
-    if (*s == '-') {
-        s++;
-        fact = -1;
-    }
-
-    for (int point_seen = 0; *s; s++) {
-        if (*s == '.') {
-            point_seen = 1; 
-            continue;
-        }
-
-        int d = *s - '0';
-        if (d >= 0 && d <= 9) {
-            if (point_seen) fact /= 10.0f;
-            rez = rez * 10.0f + (float)d;
-        }
-    }
-
-    return rez * fact;
-};
-
 void BancorConverter::transfer(name from, name to, asset quantity, string memo) {
-    if (from == _self) {
-        // TODO: prevent withdrawal of funds
+    // outgoing transfers are handled in apply
+    if (from == _self || to != _self) 
         return;
-    }
 
-    if (to != _self) 
-        return;
+    track_reserve_balance(_code, quantity);
 
     if (memo == "setup") {
         // TODO: emit price data event
@@ -360,11 +263,19 @@ void BancorConverter::transfer(name from, name to, asset quantity, string memo)
 extern "C" {
     [[noreturn]] void apply(uint64_t receiver, uint64_t code, uint64_t action) {
         if (action == "transfer"_n.value && code != receiver) {
-            eosio::execute_action(eosio::name(receiver), eosio::name(code), &BancorConverter::transfer);
+            // outgoing transfers only update the tracked reserve balance and don't need the memo,
+            // transfers between other accounts are ignored
+            auto transfer = read_transfer_prefix();
+            if (transfer.from.value == receiver) {
+                BancorConverter converter(eosio::name(receiver), eosio::name(code), datastream<const char*>(nullptr, 0));
+                converter.track_reserve_balance(eosio::name(code), -transfer.quantity);
+            }
+            else if (transfer.to.value == receiver)
+                eosio::execute_action(eosio::name(receiver), eosio::name(code), &BancorConverter::transfer);
         }
         if (code == receiver) {
             switch (action) { 
-                EOSIO_DISPATCH_HELPER(BancorConverter, (init)(update)(setreserve)) 
+                EOSIO_DISPATCH_HELPER(BancorConverter, (init)(update)(setreserve)(resync)) 
             }    
         }
         eosio_exit(0);
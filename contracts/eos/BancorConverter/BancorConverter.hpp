@@ -5,7 +5,9 @@
 #include <eosiolib/asset.hpp>
 #include <eosiolib/symbol.hpp>
 #include <eosiolib/singleton.hpp>
+#include <eosiolib/binary_extension.hpp>
 #include "../Common/common.hpp"
+#include "../Common/conversion.hpp"
 
 using namespace eosio;
 using std::string;
@@ -14,26 +16,26 @@ using std::vector;
 // events
 // triggered when a conversion between two tokens occurs
 #define EMIT_CONVERSION_EVENT(memo, from_contract, from_symbol, to_contract, to_symbol, from_amount, to_amount, fee_amount) \
-    START_EVENT("conversion", "1.2") \
-    EVENTKV("memo", memo) \
-    EVENTKV("from_contract", from_contract) \
-    EVENTKV("from_symbol", from_symbol) \
-    EVENTKV("to_contract", to_contract) \
-    EVENTKV("to_symbol", to_symbol) \
-    EVENTKV("amount", from_amount) \
-    EVENTKV("return", to_amount) \
-    EVENTKVL("conversion_fee", fee_amount) \
-    END_EVENT()
+    event_writer("conversion", "1.2") \
+        .kv("memo", memo) \
+        .kv("from_contract", from_contract) \
+        .kv("from_symbol", from_symbol) \
+        .kv("to_contract", to_contract) \
+        .kv("to_symbol", to_symbol) \
+        .kv("amount", from_amount) \
+        .kv("return", to_amount) \
+        .kv("conversion_fee", fee_amount) \
+        .end();
 
 // triggered after a conversion with new tokens price data
 #define EMIT_PRICE_DATA_EVENT(smart_supply, reserve_contract, reserve_symbol, reserve_balance, reserve_ratio) \
-    START_EVENT("price_data", "1.2") \
-    EVENTKV("smart_supply", smart_supply) \
-    EVENTKV("reserve_contract", reserve_contract) \
-    EVENTKV("reserve_symbol", reserve_symbol) \
-    EVENTKV("reserve_balance", reserve_balance) \
-    EVENTKVL("reserve_ratio", reserve_ratio) \
-    END_EVENT()
+    event_writer("price_data", "1.2") \
+        .kv("smart_supply", smart_supply) \
+        .kv("reserve_contract", reserve_contract) \
+        .kv("reserve_symbol", reserve_symbol) \
+        .kv("reserve_balance", reserve_balance) \
+        .kv("reserve_ratio", reserve_ratio) \
+        .end();
 
 /*
     Bancor Converter
@@ -45,7 +47,43 @@ using std::vector;
     the virtual balance instead of relying on the actual reserve balance.
     This is a security mechanism that prevents the need to keep a very large
     (and valuable) balance in a single contract.
+
+    The converter keeps its own ledger of the reserve balances and the smart token supply,
+    updated by the reserve transfer notifications and by the smart token issue/retire
+    actions it sends, so conversions don't read the token contracts tables.
+    Tokens issued or retired directly by the converter account aren't tracked,
+    resync should be called after such changes.
+    Converters set up before the balances were tracked don't have them in their rows,
+    the token contracts are read instead until the rows are written again (see get_settings and get_reserve).
+
+    Changes to the settings or reserves are copied to the network's converter registry.
 */
+
+// eosio.token tables
+struct account {
+    asset    balance;
+    uint64_t primary_key() const { return balance.symbol.code().raw(); }
+};
+
+TABLE currency_stats {
+    asset   supply;
+    asset   max_supply;
+    name    issuer;
+    uint64_t primary_key() const { return supply.symbol.code().raw(); }
+};
+
+typedef eosio::multi_index<"stat"_n, currency_stats> stats;
+typedef eosio::multi_index<"accounts"_n, account> accounts;
+
+// the leading fields of an entry in the network's converter registry, see BancorNetwork::converter_t
+TABLE network_converter_t {
+    name converter;
+    bool enabled;
+    uint64_t primary_key() const { return converter.value; }
+};
+
+typedef eosio::multi_index<"converters"_n, network_converter_t> network_converters;
+
 CONTRACT BancorConverter : public eosio::contract {
     using contract::contract;
     public:
@@ -59,7 +97,8 @@ CONTRACT BancorConverter : public eosio::contract {
             bool     require_balance;
             uint64_t max_fee;
             uint64_t fee;
-            EOSLIB_SERIALIZE(settings_t, (smart_contract)(smart_currency)(smart_enabled)(enabled)(network)(require_balance)(max_fee)(fee))
+            binary_extension<asset> smart_supply;   // tracked smart token supply
+            EOSLIB_SERIALIZE(settings_t, (smart_contract)(smart_currency)(smart_enabled)(enabled)(network)(require_balance)(max_fee)(fee)(smart_supply))
         };
 
         TABLE reserve_t {
@@ -67,6 +106,7 @@ CONTRACT BancorConverter : public eosio::contract {
             asset    currency;
             uint64_t ratio;
             bool     p_enabled;
+            binary_extension<asset> balance;        // tracked converter balance of the reserve token
             uint64_t primary_key() const { return currency.symbol.code().raw(); }
         };
 
@@ -99,28 +139,107 @@ CONTRACT BancorConverter : public eosio::contract {
                           uint64_t ratio,       // reserve ratio, percentage, 0-1000
                           bool     p_enabled);  // true if purchases are enabled with the reserve, false if not
 
+        // updates the tracked reserve balances and smart token supply from the token contracts
+        // can only be called by the contract account
+        ACTION resync();
+
         // transfer intercepts
         // memo is in csv format, values -
-        // version          version number, currently 1
+        // version          version number, 1, 1.1 or 2 (see MEMO_VERSION in Common/common.hpp)
+        // hop              version 1.1 only, index of the next conversion step in the path
         // path             conversion path, see conversion path in the BancorNetwork contract
         // minimum return   conversion minimum return amount, the conversion will fail if the amount returned is lower than the given amount
         // target account   account to receive the conversion return
         void transfer(name from, name to, asset quantity, string memo);
 
-    private:
-        void convert(name from, eosio::asset quantity, std::string memo, name code);
-        const reserve_t& get_reserve(uint64_t name, const settings_t& settings);
+        // updates the tracked balance of a reserve, transfers of other tokens are ignored
+        // called for outgoing reserve transfers, see apply
+        void track_reserve_balance(name contract, asset delta);
 
-        asset get_balance(name contract, name owner, symbol_code sym);
-        uint64_t get_balance_amount(name contract, name owner, symbol_code sym);
-        asset get_supply(name contract, symbol_code sym);
+        // calculates a conversion step from the tracked converter state
+        // the 'from' reserve balance shouldn't include the converted amount
+        // shared with the network contract, which calculates whole paths before sending them
+        static conversion_result calculate_conversion(const settings_t& settings, const reserve_t& from_token, const reserve_t& to_token, int64_t amount);
 
-        void verify_entry(name account, name currency_contact, eosio::asset currency);
-        void verify_min_return(eosio::asset quantity, std::string min_return);
+        // returns the settings of the given converter, with the smart token supply
+        static settings_t get_settings(name converter);
+
+        // returns a reserve of the given converter, with its balance
+        // can also be called for the smart token itself
+        static reserve_t get_reserve(name converter, symbol_code symbol, const settings_t& settings);
+
+        // returns the balance amount of an account, 0 if it has no balance
+        static int64_t get_balance_amount(name contract, name owner, symbol_code sym);
 
-        double calculate_purchase_return(double balance, double deposit_amount, double supply, int64_t ratio);
-        double calculate_sale_return(double balance, double sell_amount, double supply, int64_t ratio);
-        double quick_convert(double balance, double in, double toBalance);
+        // returns the supply of a token
+        static asset get_supply(name contract, symbol_code sym);
 
-        float stof(const char* s);
+        // returns true if the account is an enabled converter in the given network's registry
+        static bool is_network_converter(name account, name network);
+
+    private:
+        void convert(name from, eosio::asset quantity, const string& memo, name code);
+        void update_network_registry(name network);
+
+        void verify_entry(name account, name currency_contact, eosio::asset currency);
+        void verify_min_return(eosio::asset quantity, const memo_structure& memo);
 };
+
+inline conversion_result BancorConverter::calculate_conversion(const settings_t& settings, const reserve_t& from_token, const reserve_t& to_token, int64_t amount) {
+    auto smart_symbol = settings.smart_currency.symbol.code();
+    conversion_token from{ from_token.balance->amount + from_token.currency.amount, from_token.ratio, from_token.currency.symbol.code() == smart_symbol };
+    conversion_token to{ to_token.balance->amount + to_token.currency.amount, to_token.ratio, to_token.currency.symbol.code() == smart_symbol };
+    return ::calculate_conversion(from, to, settings.smart_supply->amount + settings.smart_currency.amount, settings.fee, amount);
+}
+
+inline BancorConverter::settings_t BancorConverter::get_settings(name converter) {
+    settings settings_table(converter, converter.value);
+    auto st = settings_table.get();
+    // the supply isn't tracked yet, it's written with the next settings change
+    if (!st.smart_supply.has_value())
+        st.smart_supply = get_supply(st.smart_contract, st.smart_currency.symbol.code());
+    return st;
+}
+
+inline BancorConverter::reserve_t BancorConverter::get_reserve(name converter, symbol_code symbol, const settings_t& settings) {
+    if (settings.smart_currency.symbol.code() == symbol) {
+        reserve_t temp_reserve;
+        temp_reserve.ratio = 0;
+        temp_reserve.contract = settings.smart_contract;
+        temp_reserve.currency = settings.smart_currency;
+        temp_reserve.p_enabled = settings.smart_enabled;
+        temp_reserve.balance = asset(0, settings.smart_currency.symbol);
+        return temp_reserve;
+    }
+
+    reserves reserves_table(converter, converter.value);
+    auto existing = reserves_table.find(symbol.raw());
+    eosio_assert(existing != reserves_table.end(), "reserve not found");
+    auto reserve = *existing;
+    // the balance isn't tracked yet, it's written with the next balance change
+    if (!reserve.balance.has_value())
+        reserve.balance = asset(get_balance_amount(reserve.contract, converter, symbol), reserve.currency.symbol);
+    return reserve;
+}
+
+inline int64_t BancorConverter::get_balance_amount(name contract, name owner, symbol_code sym) {
+    accounts accountstable(contract, owner.value);
+
+    auto ac = accountstable.find(sym.raw());
+    if (ac != accountstable.end())
+        return ac->balance.amount;
+
+    return 0;
+}
+
+inline asset BancorConverter::get_supply(name contract, symbol_code sym) {
+    stats statstable(contract, sym.raw());
+    const auto& st = statstable.get(sym.raw());
+    return st.supply;
+}
+
+inline bool BancorConverter::is_network_converter(name account, name network) {
+    network_converters converters_table(network, network.value);
+    auto existing = converters_table.find(account.value);
+    return existing != converters_table.end() && existing->enabled;
+}
@@ -1,5 +1,6 @@
 #include "./BancorNetwork.hpp"
 #include "../Common/common.hpp"
+#include "../Common/dispatcher.hpp"
 #include "../BancorConverter/BancorConverter.hpp"
 
 using namespace eosio;
@@ -8,6 +9,64 @@ ACTION BancorNetwork::init() {
     require_auth(_self);
 }
 
+ACTION BancorNetwork::regconverter(name converter) {
+    // only the network adds converters, registered converters refresh their own entry and pay for its ram
+    bool admin = has_auth(_self);
+    if (!admin)
+        require_auth(converter);
+
+    converters converters_table(_self, _self.value);
+    auto existing = converters_table.find(converter.value);
+    // converters refresh the registry from their setup actions, before they're registered
+    if (existing == converters_table.end() && !admin)
+        return;
+    name payer = admin ? _self : converter;
+
+    BancorConverter::settings settings_table(converter, converter.value);
+    eosio_assert(settings_table.exists(), "converter doesn\'t exist");
+    const auto& st = settings_table.get();
+    eosio_assert(st.network == _self, "converter belongs to a different network");
+
+    vector<registry_reserve> converter_reserves;
+    BancorConverter::reserves converter_reserves_table(converter, converter.value);
+    for (auto& reserve : converter_reserves_table)
+        converter_reserves.push_back({ reserve.contract, reserve.currency.symbol.code(), reserve.p_enabled });
+
+    auto set_entry = [&](auto& c) {
+        c.converter      = converter;
+        c.enabled        = st.enabled;
+        c.smart_contract = st.smart_contract;
+        c.smart_symbol   = st.smart_currency.symbol.code();
+        c.smart_enabled  = st.smart_enabled;
+        c.reserves       = converter_reserves;
+    };
+
+    if (existing != converters_table.end())
+        converters_table.modify(existing, payer, set_entry);
+    else
+        converters_table.emplace(payer, set_entry);
+
+    remove_reserves(converter);
+    reserves reserves_table(_self, _self.value);
+    for (auto& reserve : converter_reserves)
+        reserves_table.emplace(payer, [&](auto& r) {
+            r.id        = reserves_table.available_primary_key();
+            r.converter = converter;
+            r.symbol    = reserve.symbol;
+        });
+}
+
+ACTION BancorNetwork::rmconverter(name converter) {
+    require_auth(_self);
+
+    converters converters_table(_self, _self.value);
+    auto existing = converters_table.find(converter.value);
+    eosio_assert(existing != converters_table.end(), "converter doesn\'t exist");
+    converters_table.erase(existing);
+
+    remove_reserves(converter);
+}
+
 void BancorNetwork::transfer(name from, name to, asset quantity, string memo) {
     if (to != _self)
         return;
@@ -15,45 +74,298 @@ void BancorNetwork::transfer(name from, name to, asset quantity, string memo) {
     eosio_assert(quantity.symbol.is_valid(), "invalid quantity in transfer");
     eosio_assert(quantity.amount != 0, "zero quantity is disallowed in transfer");
 
-    auto memo_object = parse_memo(memo);
-    eosio_assert(memo_object.path.size() >= 2, "bad path format");
+    if (memo == DEPOSIT_MEMO) {
+        // the deposit rows are paid for by their owners, see open
+        deposits deposits_table(_self, from.value);
+        auto existing = deposits_table.find(quantity.symbol.code().raw());
+        eosio_assert(existing != deposits_table.end(), "deposit isn't open");
+        eosio_assert(existing->contract == _code && existing->balance.symbol == quantity.symbol, "deposit token mismatch");
+        deposits_table.modify(existing, same_payer, [&](auto& d) {
+            d.balance += quantity;
+        });
+        return;
+    }
 
-    name next_converter = memo_object.converters[0];
-    eosio_assert(isConverter(next_converter), "converter doesn\'t exist");
+    auto memo_object = parse_memo(memo);
+    eosio_assert(memo_object.remaining_hops() > 0, "bad path format");
 
-    const name destination_account = name(memo_object.dest_account.c_str());
+    const name destination_account = memo_object.destination();
     // the 'from' param must be either the destination account, or a valid, whitelisted converter (in case it's a "2-hop" conversion path)
     if (from != destination_account && destination_account != BANCOR_X) {
         eosio_assert(isConverter(from), "the destination account must by either the sender, or the BancorX contract account");
     }
-    
+
+    // every step is validated before any of them is calculated
+    vector<converter_state> converters;
+    validate_path(memo_object, _code, quantity.symbol.code());
+    auto path_return = calculate_path_return(memo_object, quantity, converters);
+    eosio_assert(path_return.amount >= memo_object.min_return_units(path_return.symbol.precision()), "below min return");
+
     action(
         permission_level{ _self, "active"_n },
         _code, "transfer"_n,
-        std::make_tuple(_self, next_converter, quantity, memo)
+        std::make_tuple(_self, memo_object.current_hop().converter_name(), quantity, memo)
     ).send();
 }
 
-bool BancorNetwork::isConverter(name converter) {
-    BancorConverter::settings settings_table(converter, converter.value);
-    bool settings_exists = settings_table.exists();
-    if (!settings_exists)
-        return false;
-    
-    const auto& st = settings_table.get();
+BancorConverter::reserve_t& BancorNetwork::converter_state::reserve(symbol_code symbol) {
+    for (auto& r : reserves)
+        if (r.currency.symbol.code() == symbol)
+            return r;
+
+    reserves.push_back(BancorConverter::get_reserve(converter, symbol, settings));
+    return reserves.back();
+}
+
+ACTION BancorNetwork::convertbatch(name owner, const vector<conversion_item>& conversions) {
+    require_auth(owner);
+    eosio_assert(!conversions.empty(), "empty conversion batch");
+
+    // deposits are updated in memory and written once after the whole batch
+    deposits deposits_table(_self, owner.value);
+    vector<deposit_t> balances;
+    vector<converter_state> converters;
+
+    for (auto& item : conversions) {
+        eosio_assert(item.quantity.is_valid() && item.quantity.amount > 0, "invalid conversion quantity");
+        // BancorX needs a memo with the target blockchain and account, which a batch item doesn't have
+        eosio_assert(item.destination == owner, "the destination account must be the owner");
+
+        memo_structure path;
+        parse_path(path, item.path);
+        eosio_assert(path.hop_count > 0, "bad path format");
+
+        auto deposit = std::find_if(balances.begin(), balances.end(), [&](const deposit_t& d) { return d.balance.symbol == item.quantity.symbol; });
+        if (deposit == balances.end()) {
+            auto existing = deposits_table.find(item.quantity.symbol.code().raw());
+            eosio_assert(existing != deposits_table.end() && existing->balance.symbol == item.quantity.symbol, "no deposit for the conversion token");
+            balances.push_back(*existing);
+            deposit = balances.end() - 1;
+        }
+        eosio_assert(deposit->balance.amount >= item.quantity.amount, "insufficient deposit");
+        deposit->balance -= item.quantity;
+
+        path.packed = true;
+        path.min_return_amount = item.min_return.amount;
+        validate_path(path, deposit->contract, item.quantity.symbol.code());
+        auto path_return = calculate_path_return(path, item.quantity, converters);
+        eosio_assert(item.min_return.symbol == path_return.symbol, "minimum return symbol mismatch");
+        eosio_assert(path_return.amount >= item.min_return.amount, "below min return");
+
+        action(
+            permission_level{ _self, "active"_n },
+            deposit->contract, "transfer"_n,
+            std::make_tuple(_self, path.current_hop().converter_name(), item.quantity, build_packed_memo(path, item.min_return.amount, item.destination))
+        ).send();
+    }
+
+    for (auto& balance : balances) {
+        auto existing = deposits_table.find(balance.balance.symbol.code().raw());
+        deposits_table.modify(existing, same_payer, [&](auto& d) {
+            d.balance = balance.balance;
+        });
+    }
+
+    EMIT_BATCH_CONVERSION_EVENT(owner, uint64_t(conversions.size()));
+}
+
+ACTION BancorNetwork::open(name owner, name contract, symbol symbol) {
+    require_auth(owner);
+    eosio_assert(symbol.is_valid(), "invalid symbol");
+
+    deposits deposits_table(_self, owner.value);
+    auto existing = deposits_table.find(symbol.code().raw());
+    if (existing != deposits_table.end()) {
+        eosio_assert(existing->contract == contract && existing->balance.symbol == symbol, "deposit token mismatch");
+        return;
+    }
 
-    return st.enabled;
+    eosio_assert(is_registry_reserve(contract, symbol.code()), "deposit token is not a registered reserve");
+    deposits_table.emplace(owner, [&](auto& d) {
+        d.contract = contract;
+        d.balance  = asset(0, symbol);
+    });
+}
+
+ACTION BancorNetwork::close(name owner, symbol_code symbol) {
+    require_auth(owner);
+
+    deposits deposits_table(_self, owner.value);
+    auto existing = deposits_table.find(symbol.raw());
+    eosio_assert(existing != deposits_table.end(), "no deposit for the token");
+    eosio_assert(existing->balance.amount == 0, "cannot close a deposit with a balance");
+    deposits_table.erase(existing);
+}
+
+ACTION BancorNetwork::withdraw(name owner, asset quantity) {
+    require_auth(owner);
+    eosio_assert(quantity.is_valid() && quantity.amount > 0, "invalid quantity");
+
+    deposits deposits_table(_self, owner.value);
+    auto existing = deposits_table.find(quantity.symbol.code().raw());
+    eosio_assert(existing != deposits_table.end() && existing->balance.symbol == quantity.symbol, "no deposit for the token");
+    eosio_assert(existing->balance.amount >= quantity.amount, "insufficient deposit");
+
+    name contract = existing->contract;
+    deposits_table.modify(existing, same_payer, [&](auto& d) {
+        d.balance -= quantity;
+    });
+
+    action(
+        permission_level{ _self, "active"_n },
+        contract, "transfer"_n,
+        std::make_tuple(_self, owner, quantity, string("withdraw"))
+    ).send();
+}
+
+ACTION BancorNetwork::quote(string path, asset quantity) {
+    eosio_assert(quantity.is_valid() && quantity.amount > 0, "invalid quantity");
+
+    memo_structure parsed_path;
+    parse_path(parsed_path, path);
+    eosio_assert(parsed_path.hop_count > 0, "bad path format");
+
+    vector<converter_state> converters;
+    validate_path(parsed_path, name(), quantity.symbol.code());
+    calculate_path_return(parsed_path, quantity, converters, true);
+}
+
+// removes the reserve symbol index rows of a converter
+void BancorNetwork::remove_reserves(name converter) {
+    reserves reserves_table(_self, _self.value);
+    auto by_converter = reserves_table.get_index<"byconverter"_n>();
+    for (auto reserve = by_converter.find(converter.value); reserve != by_converter.end() && reserve->converter == converter;)
+        reserve = by_converter.erase(reserve);
+}
+
+// validates every remaining step in the path against the registry, before anything is calculated or sent
+// an empty from_contract accepts the 'from' reserve of the first step regardless of its token contract
+// the converter performs the same checks, so a path fails with the same error it would during the conversion
+void BancorNetwork::validate_path(const memo_structure& path, name from_contract, symbol_code from_symbol) {
+    converters converters_table(_self, _self.value);
+
+    for (uint8_t i = path.hop; i < path.hop_count; ++i) {
+        auto converter = converters_table.find(path.hops[i].converter_name().value);
+        eosio_assert(converter != converters_table.end(), "converter doesn\'t exist");
+        eosio_assert(converter->enabled, "converter is disabled");
+        // a converter can't transfer the return of a step to itself
+        eosio_assert(i == path.hop || path.hops[i - 1].converter_name() != converter->converter, "consecutive steps cannot use the same converter");
+
+        auto to_symbol = path.hops[i].to_symbol_code();
+        eosio_assert(from_symbol != to_symbol, "cannot convert to self");
+
+        // the smart token is treated as a reserve, the same way the converter does
+        registry_reserve from_token{}, to_token{};
+        bool from_found = false, to_found = false;
+        if (from_symbol == converter->smart_symbol) {
+            from_token = { converter->smart_contract, converter->smart_symbol, converter->smart_enabled };
+            from_found = true;
+        }
+        if (to_symbol == converter->smart_symbol) {
+            to_token = { converter->smart_contract, converter->smart_symbol, converter->smart_enabled };
+            to_found = true;
+        }
+        for (auto& reserve : converter->reserves) {
+            if (reserve.symbol == from_symbol) {
+                from_token = reserve;
+                from_found = true;
+            }
+            else if (reserve.symbol == to_symbol) {
+                to_token = reserve;
+                to_found = true;
+            }
+        }
+
+        eosio_assert(from_found && to_found, "reserve not found");
+        eosio_assert(to_token.p_enabled, "'to' token purchases disabled");
+        eosio_assert(from_token.contract == from_contract || from_contract == name(), "unknown 'from' contract");
+        if (to_symbol == converter->smart_symbol)
+            eosio_assert(i == path.hop_count - 1, "smart token must be final currency");
+
+        from_symbol = to_symbol;
+        from_contract = to_token.contract;
+    }
+}
+
+// calculates the return of the remaining steps in a validated path
+// converters holds the state of the converters used so far and is updated after every step,
+// since a converter can appear more than once in a path or a batch
+asset BancorNetwork::calculate_path_return(const memo_structure& path, asset quantity, vector<converter_state>& converters, bool emit_quotes) {
+    int64_t amount = quantity.amount;
+    symbol from_currency = quantity.symbol;
+    for (uint8_t i = path.hop; i < path.hop_count; ++i) {
+        name converter_name = path.hops[i].converter_name();
+        auto converter = std::find_if(converters.begin(), converters.end(), [&](const converter_state& c) { return c.converter == converter_name; });
+        if (converter == converters.end()) {
+            converters.push_back({ converter_name, BancorConverter::get_settings(converter_name) });
+            converter = converters.end() - 1;
+        }
+
+        auto from_symbol = from_currency.code();
+        auto to_symbol = path.hops[i].to_symbol_code();
+        auto smart_symbol = converter->settings.smart_currency.symbol.code();
+
+        // both reserves are loaded before holding references to them, loading a reserve can reallocate the list
+        converter->reserve(from_symbol);
+        auto& to_token = converter->reserve(to_symbol);
+        auto& from_token = converter->reserve(from_symbol);
+
+        auto result = BancorConverter::calculate_conversion(converter->settings, from_token, to_token, amount);
+
+        if (from_symbol != smart_symbol)
+            from_token.balance->amount += amount;
+        if (to_symbol != smart_symbol)
+            to_token.balance->amount -= result.to_amount;
+        converter->settings.smart_supply->amount = result.smart_supply - converter->settings.smart_currency.amount;
+
+        auto to_currency = to_token.currency.symbol;
+        if (emit_quotes)
+            EMIT_QUOTE_EVENT(converter_name, from_symbol, to_symbol,
+                             decimal_amount({ amount, from_currency.precision() }),
+                             decimal_amount({ result.to_amount, to_currency.precision() }),
+                             decimal_amount({ result.fee_amount, to_currency.precision() }));
+
+        amount = result.to_amount;
+        from_currency = to_currency;
+    }
+
+    return asset(amount, from_currency);
+}
+
+// returns true if the token is a reserve of an enabled registered converter
+bool BancorNetwork::is_registry_reserve(name contract, symbol_code symbol) {
+    converters converters_table(_self, _self.value);
+    reserves reserves_table(_self, _self.value);
+    auto by_symbol = reserves_table.get_index<"bysymbol"_n>();
+    for (auto reserve = by_symbol.find(symbol.raw()); reserve != by_symbol.end() && reserve->symbol == symbol; ++reserve) {
+        auto converter = converters_table.find(reserve->converter.value);
+        if (converter == converters_table.end() || !converter->enabled)
+            continue;
+
+        for (auto& r : converter->reserves)
+            if (r.symbol == symbol && r.contract == contract)
+                return true;
+    }
+    return false;
+}
+
+// returns true if the account is a registered and enabled converter
+bool BancorNetwork::isConverter(name converter) {
+    converters converters_table(_self, _self.value);
+    auto existing = converters_table.find(converter.value);
+    return existing != converters_table.end() && existing->enabled;
 }
 
 extern "C" {
     [[noreturn]] void apply(uint64_t receiver, uint64_t code, uint64_t action) {
 
-        if (action == "transfer"_n.value && code != receiver) {
+        // transfers are fully deserialized only when they're incoming
+        if (action == "transfer"_n.value && code != receiver && is_incoming_transfer(receiver)) {
             eosio::execute_action( eosio::name(receiver), eosio::name(code), &BancorNetwork::transfer );
         }
         if (code == receiver){
             switch( action ) { 
-                EOSIO_DISPATCH_HELPER( BancorNetwork, (init) ) 
+                EOSIO_DISPATCH_HELPER( BancorNetwork, (init)(regconverter)(rmconverter)(convertbatch)(open)(close)(withdraw)(quote) ) 
             }    
         }
         eosio_exit(0);
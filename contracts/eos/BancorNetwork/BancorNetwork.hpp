@@ -3,12 +3,35 @@
 #include <eosiolib/eosio.hpp>
 #include <eosiolib/transaction.hpp>
 #include <eosiolib/asset.hpp>
+#include "../Common/common.hpp"
+#include "../BancorConverter/BancorConverter.hpp"
 
 using namespace eosio;
 
 using std::string;
 using std::vector;
 
+#define DEPOSIT_MEMO "deposit" // transfers with this memo are credited to the sender's deposit for batch conversions
+
+// events
+// triggered after a batch of conversions is sent
+#define EMIT_BATCH_CONVERSION_EVENT(owner, conversions) \
+    event_writer("batch_conversion", "1.0") \
+        .kv("owner", owner) \
+        .kv("conversions", conversions) \
+        .end();
+
+// triggered by quote for every step in the path
+#define EMIT_QUOTE_EVENT(converter, from_symbol, to_symbol, amount, to_amount, fee_amount) \
+    event_writer("quote", "1.0") \
+        .kv("converter", converter) \
+        .kv("from_symbol", from_symbol) \
+        .kv("to_symbol", to_symbol) \
+        .kv("amount", amount) \
+        .kv("return", to_amount) \
+        .kv("conversion_fee", fee_amount) \
+        .end();
+
 /*
     The BancorNetwork contract is the main entry point for bancor token conversions.
     It also allows converting between any token in the bancor network to any other token
@@ -30,22 +53,142 @@ using std::vector;
     and provide the following memo:
 
     1,bnt2eoscnvrt BNT,1.0000000000,receiver_account_name
+
+    Version 1.1 memos add a hop index after the version and are forwarded between
+    converters with only that index advanced, which is cheaper for long paths:
+
+    1.1,0,bnt2eoscnvrt BNT,1.0000000000,receiver_account_name
+
+    Version 2 memos pack the path, minimum return and target account as binary values
+    so contracts decode them with integer loads instead of parsing text:
+
+    2,<base64 payload>
+
+    Converters are registered in the network's converters table, which routing and
+    path validation read instead of the converters' own tables.
+
+    The network validates every step in the path and then calculates the return of every step
+    from the converters' tracked state before sending anything, so invalid paths and paths
+    that would end below the minimum return fail immediately.
+    The tokens are then sent to the first converter and each converter sends its return
+    directly to the converter of the next step, the last one sends it to the target account.
+
+    Accounts that send many conversions can deposit tokens in the network once, by transferring
+    them with the memo "deposit", and then convert them in batches with convertbatch.
+    The deposit of a token has to be opened first with open, the owner pays for its row,
+    and only reserve tokens of registered converters can be deposited.
 */
 CONTRACT BancorNetwork : public eosio::contract {
     using contract::contract;
     public:
 
+        // a reserve of a registered converter
+        struct registry_reserve {
+            name        contract;
+            symbol_code symbol;
+            bool        p_enabled;
+            EOSLIB_SERIALIZE(registry_reserve, (contract)(symbol)(p_enabled))
+        };
+
+        // converters registered in the network, with a copy of the settings and reserves used to route conversions
+        TABLE converter_t {
+            name                        converter;
+            bool                        enabled;
+            name                        smart_contract;
+            symbol_code                 smart_symbol;
+            bool                        smart_enabled;
+            vector<registry_reserve>    reserves;
+            uint64_t primary_key() const { return converter.value; }
+        };
+
+        // registered converters by reserve symbol, a row for every reserve of every converter
+        TABLE reserve_t {
+            uint64_t    id;
+            name        converter;
+            symbol_code symbol;
+            uint64_t primary_key() const { return id; }
+            uint64_t by_symbol() const { return symbol.raw(); }
+            uint64_t by_converter() const { return converter.value; }
+        };
+
+        // tokens deposited for batch conversions, scoped by owner
+        TABLE deposit_t {
+            name    contract;
+            asset   balance;
+            uint64_t primary_key() const { return balance.symbol.code().raw(); }
+        };
+
+        // a single conversion in a batch
+        struct conversion_item {
+            string  path;           // conversion path, see description above
+            asset   quantity;       // amount to convert, taken from the owner's deposit
+            asset   min_return;     // conversion minimum return, in the target token
+            name    destination;    // account to receive the conversion return, must be the owner
+            EOSLIB_SERIALIZE(conversion_item, (path)(quantity)(min_return)(destination))
+        };
+
+        typedef eosio::multi_index<"converters"_n, converter_t> converters;
+        typedef eosio::multi_index<"deposits"_n, deposit_t> deposits;
+        typedef eosio::multi_index<"reserves"_n, reserve_t,
+            indexed_by<"bysymbol"_n, const_mem_fun<reserve_t, uint64_t, &reserve_t::by_symbol>>,
+            indexed_by<"byconverter"_n, const_mem_fun<reserve_t, uint64_t, &reserve_t::by_converter>>
+        > reserves;
 
         ACTION init();
 
+        // adds a converter to the registry or updates its registry entry from the converter settings and reserves
+        // only the contract account can add converters, registered converters call it when their settings change
+        // and pay for the ram of their entry, calls by converters that aren't registered are ignored
+        ACTION regconverter(name converter);
+
+        // removes a converter from the registry
+        // can only be called by the contract account
+        ACTION rmconverter(name converter);
+
+        // converts deposited tokens, the conversions are validated, calculated and sent in order
+        // converter state is loaded once for the whole batch, can only be called by the owner
+        ACTION convertbatch(name owner, const vector<conversion_item>& conversions);
+
+        // prints a quote event with the return and fee of every step in the path, without sending anything
+        // uses the same calculation as the converters, meant to be run as a read-only transaction
+        ACTION quote(string path,       // conversion path, see description above
+                     asset quantity);   // amount of the 'from' token to convert
+
+        // opens the owner's deposit of a token, the owner pays for its row
+        // the token must be a reserve of a registered converter, can only be called by the owner
+        ACTION open(name owner, name contract, symbol symbol);
+
+        // removes the owner's deposit of a token, the deposit must be empty
+        // can only be called by the owner
+        ACTION close(name owner, symbol_code symbol);
+
+        // sends deposited tokens back to the owner, the deposit stays open
+        // can only be called by the owner
+        ACTION withdraw(name owner, asset quantity);
+
         // transfer intercepts
         // memo is in csv format, values -
-        // version          version number, currently 1
+        // version          version number, 1, 1.1 or 2 (see MEMO_VERSION in Common/common.hpp)
+        // hop              version 1.1 only, index of the first conversion step to perform, usually 0
         // path             conversion path, see description above
         // minimum return   conversion minimum return amount, the conversion will fail if the amount returned is lower than the given amount
         // target account   account to receive the conversion return
+        // transfers with the memo "deposit" are added to the sender's deposit instead
         void transfer(name from, name to, asset quantity, string memo);
     
     private:
+        // a converter's state while a path is calculated
+        struct converter_state {
+            name                                converter;
+            BancorConverter::settings_t         settings;
+            vector<BancorConverter::reserve_t>  reserves;   // reserves used by the path, loaded on first use
+
+            BancorConverter::reserve_t& reserve(symbol_code symbol);
+        };
+
         bool isConverter(name converter);
+        bool is_registry_reserve(name contract, symbol_code symbol);
+        void remove_reserves(name converter);
+        void validate_path(const memo_structure& path, name from_contract, symbol_code from_symbol);
+        asset calculate_path_return(const memo_structure& path, asset quantity, vector<converter_state>& converters, bool emit_quotes = false);
 };
@@ -2,6 +2,7 @@
 #include <math.h>
 #include "./BancorX.hpp"
 #include "../Common/common.hpp"
+#include "../Common/dispatcher.hpp"
 
 using namespace eosio;
 
@@ -82,9 +83,31 @@ ACTION BancorX::addreporter(name reporter) {
     auto it = reporters_table.find(reporter.value);
 
     eosio_assert(it == reporters_table.end(), "reporter already defined");
+
+    uint64_t used_indexes = 0;
+    for (auto& r : reporters_table)
+        used_indexes |= 1ull << r.index;
+
+    // the indexes of removed reporters are free again once their pending transfers expired
+    uint64_t now = current_time() / 1000000;
+    retired retired_table(_self, _self.value);
+    for (auto r = retired_table.begin(); r != retired_table.end();) {
+        if (r->retired_until <= now) {
+            r = retired_table.erase(r);
+            continue;
+        }
+        used_indexes |= 1ull << r->index;
+        ++r;
+    }
+
+    uint8_t index = 0;
+    while (index < MAX_REPORTERS && (used_indexes & (1ull << index)))
+        ++index;
+    eosio_assert(index < MAX_REPORTERS, "too many reporters");
     
     reporters_table.emplace(_self, [&](auto& s) {
         s.reporter  = reporter;
+        s.index     = index;
     });
 }
 
@@ -94,7 +117,15 @@ ACTION BancorX::rmreporter(name reporter) {
     auto it = reporters_table.find(reporter.value);
 
     eosio_assert(it != reporters_table.end(), "reporter does not exist");
-    
+
+    // the reports of the removed reporter are dropped from pending transfers when they're reported next
+    // see report, the index is kept until those transfers expired
+    retired retired_table(_self, _self.value);
+    retired_table.emplace(_self, [&](auto& r) {
+        r.index         = it->index;
+        r.retired_until = current_time() / 1000000 + TRANSFER_EXPIRATION;
+    });
+
     reporters_table.erase(it);
 }
 
@@ -102,8 +133,31 @@ ACTION BancorX::reporttx(name reporter, string blockchain, uint64_t tx_id, uint6
     // checks that the reporter signed on the tx
     require_auth(reporter);
 
-    eosio_assert(memo.size() <= 256, "memo has more than 256 bytes");
+    report({ reporter }, { { blockchain, tx_id, x_transfer_id, target, quantity, memo, data } });
+}
+
+ACTION BancorX::reportmulti(const vector<name>& reporters, string blockchain, uint64_t tx_id, uint64_t x_transfer_id, name target, asset quantity, string memo, string data) {
+    eosio_assert(!reporters.empty(), "no reporters");
+
+    // checks that every reporter signed on the tx
+    for (auto& reporter : reporters)
+        require_auth(reporter);
+
+    report(reporters, { { blockchain, tx_id, x_transfer_id, target, quantity, memo, data } });
+}
+
+ACTION BancorX::reportbatch(name reporter, const vector<transfer_report>& reports) {
+    // checks that the reporter signed on the tx
+    require_auth(reporter);
+    eosio_assert(!reports.empty(), "empty report batch");
+
+    report({ reporter }, reports);
+}
 
+// records the reports of the signers, who already authorized the action, and issues every transfer
+// that reached the minimum number of reporters
+// the issue limit is calculated once for all the reports and the settings are written at most once
+void BancorX::report(const vector<name>& signers, const vector<transfer_report>& reports) {
     settings settings_table(_self, _self.value);
     auto st = settings_table.get();
 
@@ -121,88 +175,106 @@ ACTION BancorX::reporttx(name reporter, string blockchain, uint64_t tx_id, uint6
 
     uint64_t current_limit = std::min(prev_issue_limit + limit_inc * current_delta, st.max_issue_limit);
 
-    eosio_assert(quantity.amount >= st.min_limit, "below min limit");
-
-    // checks that the signer is known reporter
+    // checks that the signers are known reporters, each listed once
     reporters reporters_table(_self, _self.value);
-    auto existing = reporters_table.find(reporter.value);
-
-    eosio_assert(existing != reporters_table.end(), "the signer is not a known reporter");
+    uint64_t signers_mask = 0;
+    for (auto& reporter : signers) {
+        auto it = reporters_table.find(reporter.value);
+        eosio_assert(it != reporters_table.end(), "the signer is not a known reporter");
+        eosio_assert(!(signers_mask & (1ull << it->index)), "duplicate reporter");
+        signers_mask |= 1ull << it->index;
+    }
 
-    // checks if the reporters limits are valid
     transfers transfers_table(_self, _self.value);
-    auto transaction = transfers_table.find(tx_id);
-
-    // first reporter 
-    if (transaction == transfers_table.end()) {
-        eosio_assert(quantity.amount <= current_limit, "above max limit");
-        transfers_table.emplace(_self, [&](auto& s) {
-            s.tx_id           = tx_id;
-            s.x_transfer_id   = x_transfer_id;
-            s.target          = target;
-            s.quantity        = quantity;
-            s.blockchain      = blockchain;
-            s.memo            = memo;
-            s.data            = data;
-            s.reporters.push_back(reporter);
-        });
-
-        st.prev_issue_limit = current_limit - quantity.amount;
-        st.prev_issue_time  = timestamp;
-        settings_table.set(st, _self);
+    amounts amounts_table(_self, _self.value);
+    bool new_transfers = false;
+    uint64_t now = current_time() / 1000000;
+    uint64_t removed_reporters = 0;
+    bool removed_reporters_read = false;
+
+    for (auto& report : reports) {
+        eosio_assert(report.memo.size() <= 256, "memo has more than 256 bytes");
+        eosio_assert(report.quantity.amount >= st.min_limit, "below min limit");
+
+        // checks if the reporters limits are valid
+        auto transaction = transfers_table.find(report.tx_id);
+        auto hash = payload_hash(report);
+
+        // an expired transfer is reported again from scratch, its reporters bits may belong to other reporters by now
+        if (transaction != transfers_table.end() && transaction->report_time.value_or(0) + TRANSFER_EXPIRATION <= now) {
+            transfers_table.erase(transaction);
+            transaction = transfers_table.end();
+        }
 
-        EMIT_TX_REPORT_EVENT(reporter, blockchain, tx_id, target, quantity, x_transfer_id, memo);
-    }
-    else {
-        // checks that the reporter didn't already report the transfer
-        eosio_assert(std::find(transaction->reporters.begin(), 
-                               transaction->reporters.end(),
-                               reporter) == transaction->reporters.end(),
-                               "the reporter already reported the transfer");
-
-        eosio_assert(transaction->x_transfer_id == x_transfer_id &&
-                     transaction->target == target &&
-                     transaction->quantity == quantity &&
-                     transaction->blockchain == blockchain &&
-                     transaction->memo == memo &&
-                     transaction->data == data,
-                     "transfer data doesn't match");
-
-        transfers_table.modify(transaction, _self, [&](auto& s) {
-            s.reporters.push_back(reporter);
-        });
-        
-        EMIT_TX_REPORT_EVENT(reporter, blockchain, tx_id, target, quantity, x_transfer_id, memo);
-    }
-    // get the transaction again in case this was the first report
-    transaction = transfers_table.find(tx_id);
+        // first reporter 
+        if (transaction == transfers_table.end()) {
+            eosio_assert(report.quantity.amount <= current_limit, "above max limit");
+            transaction = transfers_table.emplace(_self, [&](auto& s) {
+                s.tx_id           = report.tx_id;
+                s.payload_hash    = hash;
+                s.reporters       = signers_mask;
+                s.reporters_count = signers.size();
+                s.report_time     = now;
+            });
 
-    // checks if we have minimal reporters for issue
-    if (transaction->reporters.size() >= st.min_reporters) {
-        // issue tokens
-        action(
-            permission_level{ _self, "active"_n },
-            st.x_token_name, "issue"_n,
-            std::make_tuple(transaction->target, transaction->quantity, memo)
-        ).send();
+            current_limit -= report.quantity.amount;
+            new_transfers = true;
+        }
+        else {
+            // checks that the reporters didn't already report the transfer
+            eosio_assert(!(transaction->reporters & signers_mask), "the reporter already reported the transfer");
 
-        EMIT_ISSUE_EVENT(target, quantity);
+            eosio_assert(transaction->payload_hash == hash, "transfer data doesn't match");
 
-        transfers_table.erase(transaction);
+            if (!removed_reporters_read) {
+                removed_reporters = retired_mask();
+                removed_reporters_read = true;
+            }
 
-        if (x_transfer_id) {
-            amounts amounts_table(_self, _self.value);
-            auto amount = amounts_table.find(x_transfer_id);
-            eosio_assert(amount == amounts_table.end(), "x_transfer_id already exists");
-            amounts_table.emplace(_self, [&](auto& a)  {
-                a.x_transfer_id = x_transfer_id;
-                a.target = target;
-                a.quantity = quantity;
+            transfers_table.modify(transaction, _self, [&](auto& s) {
+                s.reporters       = (s.reporters & ~removed_reporters) | signers_mask;
+                s.reporters_count = __builtin_popcountll(s.reporters);
             });
         }
 
-        EMIT_X_TRANSFER_COMPLETE_EVENT(target, x_transfer_id);
+        for (auto& reporter : signers)
+            EMIT_TX_REPORT_EVENT(reporter, report.blockchain, report.tx_id, report.target, report.quantity, report.x_transfer_id, report.memo);
+
+        // checks if we have minimal reporters for issue
+        if (transaction->reporters_count >= st.min_reporters) {
+            // issue tokens
+            action(
+                permission_level{ _self, "active"_n },
+                st.x_token_name, "issue"_n,
+                std::make_tuple(report.target, report.quantity, report.memo)
+            ).send();
+
+            EMIT_ISSUE_EVENT(report.target, report.quantity);
+
+            transfers_table.erase(transaction);
+
+            if (report.x_transfer_id) {
+                auto amount = amounts_table.find(report.x_transfer_id);
+                eosio_assert(amount == amounts_table.end(), "x_transfer_id already exists");
+                amounts_table.emplace(_self, [&](auto& a)  {
+                    a.x_transfer_id = report.x_transfer_id;
+                    a.target = report.target;
+                    a.quantity = report.quantity;
+                    a.issue_time = now;
+                });
+            }
+
+            EMIT_X_TRANSFER_COMPLETE_EVENT(report.target, report.x_transfer_id);
+        }
+    }
+
+    if (new_transfers) {
+        st.prev_issue_limit = current_limit;
+        st.prev_issue_time  = timestamp;
+        settings_table.set(st, _self);
     }
+
+    purge_expired(PURGE_STEP);
 }
 
 ACTION BancorX::clearamount(uint64_t x_transfer_id) {
@@ -222,6 +294,47 @@ ACTION BancorX::clearamount(uint64_t x_transfer_id) {
     amounts_table.erase(it);
 }
 
+ACTION BancorX::purge(uint32_t max_rows) {
+    eosio_assert(max_rows > 0, "max rows must be positive");
+    purge_expired(max_rows);
+}
+
+// the rows have no entries in the time indexes, which modify can't update, so they're stored again instead
+ACTION BancorX::migrate(const vector<uint64_t>& tx_ids, const vector<uint64_t>& x_transfer_ids) {
+    require_auth(_self);
+    uint64_t now = current_time() / 1000000;
+
+    transfers transfers_table(_self, _self.value);
+    for (auto tx_id : tx_ids) {
+        auto transaction = transfers_table.find(tx_id);
+        eosio_assert(transaction != transfers_table.end(), "transfer doesn't exist in table");
+        if (transaction->report_time.has_value())
+            continue;
+
+        transfer_t row = *transaction;
+        row.report_time = now;
+        transfers_table.erase(transaction);
+        transfers_table.emplace(_self, [&](auto& t) {
+            t = row;
+        });
+    }
+
+    amounts amounts_table(_self, _self.value);
+    for (auto x_transfer_id : x_transfer_ids) {
+        auto amount = amounts_table.find(x_transfer_id);
+        eosio_assert(amount != amounts_table.end(), "amount doesn't exist in table");
+        if (amount->issue_time.has_value())
+            continue;
+
+        amounts_t row = *amount;
+        row.issue_time = now;
+        amounts_table.erase(amount);
+        amounts_table.emplace(_self, [&](auto& a) {
+            a = row;
+        });
+    }
+}
+
 void BancorX::transfer(name from, name to, asset quantity, string memo) {
     if (from == _self || to != _self)
         return;
@@ -235,7 +348,7 @@ void BancorX::transfer(name from, name to, asset quantity, string memo) {
     xtransfer(memo_object.blockchain, from, memo_object.target, quantity, memo_object.x_transfer_id);
 }
 
-void BancorX::xtransfer(string blockchain, name from, string target, asset quantity, std::string x_transfer_id) {
+void BancorX::xtransfer(string_view blockchain, name from, string_view target, asset quantity, string_view x_transfer_id) {
     settings settings_table(_self, _self.value);
     auto st = settings_table.get();
 
@@ -268,17 +381,48 @@ void BancorX::xtransfer(string blockchain, name from, string target, asset quant
 
     EMIT_DESTROY_EVENT(from, quantity);
     EMIT_X_TRANSFER_EVENT(blockchain, target, quantity, x_transfer_id);
+
+    purge_expired(PURGE_STEP);
+}
+
+// returns the bits of the removed reporters, see retired_t
+// there are at most MAX_REPORTERS rows
+uint64_t BancorX::retired_mask() {
+    retired retired_table(_self, _self.value);
+    uint64_t mask = 0;
+    for (auto& r : retired_table)
+        mask |= 1ull << r.index;
+    return mask;
+}
+
+// removes the oldest expired transfers and amounts, up to max_rows of each
+// both tables are walked in time order, so only the removed rows and one more row of each are read
+void BancorX::purge_expired(uint32_t max_rows) {
+    uint64_t now = current_time() / 1000000;
+
+    transfers transfers_table(_self, _self.value);
+    auto by_report_time = transfers_table.get_index<"byreporttime"_n>();
+    auto transfer = by_report_time.begin();
+    for (uint32_t i = 0; i < max_rows && transfer != by_report_time.end() && transfer->report_time.value_or(0) + TRANSFER_EXPIRATION <= now; ++i)
+        transfer = by_report_time.erase(transfer);
+
+    amounts amounts_table(_self, _self.value);
+    auto by_issue_time = amounts_table.get_index<"byissuetime"_n>();
+    auto amount = by_issue_time.begin();
+    for (uint32_t i = 0; i < max_rows && amount != by_issue_time.end() && amount->issue_time.value_or(0) + AMOUNT_EXPIRATION <= now; ++i)
+        amount = by_issue_time.erase(amount);
 }
 
 extern "C" {
     [[noreturn]] void apply(uint64_t receiver, uint64_t code, uint64_t action) {
-        if (action == "transfer"_n.value && code != receiver) {
+        // transfers are fully deserialized only when they're incoming
+        if (action == "transfer"_n.value && code != receiver && is_incoming_transfer(receiver)) {
             eosio::execute_action(eosio::name(receiver), eosio::name(code), &BancorX::transfer);
         }
     
         if (code == receiver) {
             switch (action) { 
-                EOSIO_DISPATCH_HELPER(BancorX, (init)(update)(enablerpt)(enablext)(addreporter)(rmreporter)(reporttx)(clearamount)) 
+                EOSIO_DISPATCH_HELPER(BancorX, (init)(update)(enablerpt)(enablext)(addreporter)(rmreporter)(reporttx)(reportmulti)(reportbatch)(clearamount)(purge)(migrate)) 
             }    
         }
 
@@ -7,54 +7,61 @@
 #include <eosiolib/asset.hpp>
 #include <eosiolib/symbol.hpp>
 #include <eosiolib/singleton.hpp>
+#include <eosiolib/crypto.hpp>
+#include <eosiolib/binary_extension.hpp>
 #include "../Common/common.hpp"
 using std::string;
 using std::vector;
 
 using namespace eosio;
 
+#define MAX_REPORTERS 64 // each reporter has a bit in the reporters mask of a pending transfer
+#define TRANSFER_EXPIRATION 604800 // seconds a transfer that wasn't reported by enough reporters is kept
+#define AMOUNT_EXPIRATION 2592000 // seconds an issued amount can be transferred by its x_transfer_id
+#define PURGE_STEP 2 // expired transfers and amounts removed by every report and x transfer
+
 // events
 // triggered when an account initiates a cross chain transafer
 #define EMIT_X_TRANSFER_EVENT(blockchain, target, quantity, id) \
-    START_EVENT("xtransfer", "1.2") \
-    EVENTKV("blockchain",blockchain) \
-    EVENTKV("target",target) \
-    EVENTKV("quantity",quantity) \
-    EVENTKVL("id",id) \
-    END_EVENT()
+    event_writer("xtransfer", "1.2") \
+        .kv("blockchain", blockchain) \
+        .kv("target", target) \
+        .kv("quantity", quantity) \
+        .kv("id", id) \
+        .end();
 
 // triggered when account tokens are destroyed after cross chain transfer initiation
 #define EMIT_DESTROY_EVENT(from, quantity) \
-    START_EVENT("destroy", "1.1") \
-    EVENTKV("from",from) \
-    EVENTKVL("quantity",quantity) \
-    END_EVENT()
+    event_writer("destroy", "1.1") \
+        .kv("from", from) \
+        .kv("quantity", quantity) \
+        .end();
 
 // triggered when a reporter reports a cross chain transfer from another blockchain
 #define EMIT_TX_REPORT_EVENT(reporter, blockchain, transaction, target, quantity, x_transfer_id, memo) \
-    START_EVENT("txreport", "1.2") \
-    EVENTKV("reporter",reporter) \
-    EVENTKV("from_blockchain",blockchain) \
-    EVENTKV("transaction",transaction) \
-    EVENTKV("target",target) \
-    EVENTKV("quantity",quantity) \
-    EVENTKV("x_transfer_id",x_transfer_id) \
-    EVENTKVL("memo",memo) \
-    END_EVENT()
+    event_writer("txreport", "1.2") \
+        .kv("reporter", reporter) \
+        .kv("from_blockchain", blockchain) \
+        .kv("transaction", transaction) \
+        .kv("target", target) \
+        .kv("quantity", quantity) \
+        .kv("x_transfer_id", x_transfer_id) \
+        .kv("memo", memo) \
+        .end();
 
 // triggered when final report is succesfully submitted
 #define EMIT_X_TRANSFER_COMPLETE_EVENT(target, id) \
-    START_EVENT("xtransfercomplete", "1.2") \
-    EVENTKV("target", target) \
-    EVENTKVL("id", id) \
-    END_EVENT()
+    event_writer("xtransfercomplete", "1.2") \
+        .kv("target", target) \
+        .kv("id", id) \
+        .end();
 
 // triggered when enough reports arrived and tokens are issued to an account and the cross chain transfer is fulfilled
 #define EMIT_ISSUE_EVENT(target, quantity) \
-    START_EVENT("issue", "1.1") \
-    EVENTKV("target",target) \
-    EVENTKVL("quantity",quantity) \
-    END_EVENT()
+    event_writer("issue", "1.1") \
+        .kv("target", target) \
+        .kv("quantity", quantity) \
+        .end();
 
 /*
     The BancorX contract allows cross chain token transfers.
@@ -86,35 +93,63 @@ CONTRACT BancorX : public contract {
             EOSLIB_SERIALIZE(settings_t, (x_token_name)(rpt_enabled)(xt_enabled)(min_reporters)(min_limit)(limit_inc)(max_issue_limit)(prev_issue_limit)(prev_issue_time)(max_destroy_limit)(prev_destroy_limit)(prev_destroy_time))
         };
 
+        // a transfer that wasn't reported by enough reporters yet
+        // the reports are matched by the hash of their payload, the tokens are issued with the payload of the last report
         TABLE transfer_t {
             uint64_t        tx_id;
-            uint64_t        x_transfer_id;
-            name            target;
-            asset           quantity;
-            string          blockchain;
-            string          memo;
-            string          data;
-            vector<name>    reporters;
+            checksum256     payload_hash;       // see payload_hash
+            uint64_t        reporters;          // bit mask of the indexes of the reporters that reported the transfer
+            uint8_t         reporters_count;
+            binary_extension<uint64_t> report_time; // time of the first report, in seconds, see migrate
             uint64_t     primary_key() const { return tx_id; }
+            uint64_t     by_report_time() const { return report_time.value_or(0); }
         };
 
         TABLE amounts_t {
             uint64_t x_transfer_id;
             name target;
             asset quantity;
+            binary_extension<uint64_t> issue_time; // in seconds, see migrate
             uint64_t primary_key() const { return x_transfer_id; }
+            uint64_t by_issue_time() const { return issue_time.value_or(0); }
         };
 
         TABLE reporter_t {
             name reporter;
+            uint8_t index; // the lowest index that was free when the reporter was added, see transfer_t::reporters
             uint64_t primary_key() const { return reporter.value; }
         };
 
+        // the index of a removed reporter, pending transfers may still have its bit in their reporters mask
+        // the bit doesn't count as a report and the index isn't reused until all those transfers expired
+        TABLE retired_t {
+            uint8_t index;
+            uint64_t retired_until; // in seconds, TRANSFER_EXPIRATION after the reporter was removed
+            uint64_t primary_key() const { return index; }
+        };
+
+        // an incoming transaction from a different blockchain, see reporttx
+        struct transfer_report {
+            string      blockchain;
+            uint64_t    tx_id;
+            uint64_t    x_transfer_id;
+            name        target;
+            asset       quantity;
+            string      memo;
+            string      data;
+            EOSLIB_SERIALIZE(transfer_report, (blockchain)(tx_id)(x_transfer_id)(target)(quantity)(memo)(data))
+        };
+
         typedef eosio::singleton<"settings"_n, settings_t> settings;
         typedef eosio::multi_index<"settings"_n, settings_t> dummy_for_abi; // hack until abi generator generates correct name
-        typedef eosio::multi_index<"transfers"_n, transfer_t> transfers;
-        typedef eosio::multi_index<"amounts"_n, amounts_t> amounts;
+        typedef eosio::multi_index<"transfers"_n, transfer_t,
+            indexed_by<"byreporttime"_n, const_mem_fun<transfer_t, uint64_t, &transfer_t::by_report_time>>
+        > transfers;
+        typedef eosio::multi_index<"amounts"_n, amounts_t,
+            indexed_by<"byissuetime"_n, const_mem_fun<amounts_t, uint64_t, &amounts_t::by_issue_time>>
+        > amounts;
         typedef eosio::multi_index<"reporters"_n, reporter_t> reporters;
+        typedef eosio::multi_index<"retired"_n, retired_t> retired;
 
         // initializes the contract settings
         // can only be called once, by the contract account
@@ -137,7 +172,9 @@ CONTRACT BancorX : public contract {
         ACTION enablext(bool enable);   // true to enable cross chain transfers, false to disable them, can only be called by the contract account
 
         ACTION addreporter(name reporter);  // adds a new reporter, can only be called by the contract account
-        ACTION rmreporter(name reporter);   // remnoves an existing reporter, can only be called by the contract account
+        // removes an existing reporter, its reports of pending transfers stop counting
+        // can only be called by the contract account
+        ACTION rmreporter(name reporter);
 
         // reports an incoming transaction from a different blockchain
         // can only be called by an existing reporter
@@ -150,29 +187,63 @@ CONTRACT BancorX : public contract {
                         string memo,             // memo to pass in in the transfer action
                         string data);            // custom source blockchain value, usually a string representing the tx hash on the source blockchain
 
+        // reports an incoming transaction on behalf of several reporters at once, issuing in the same action if enough reporters signed
+        // can only be called with the authorizations of all the listed reporters, the rest of the fields are the same as in reporttx
+        ACTION reportmulti(const vector<name>& reporters, string blockchain, uint64_t tx_id, uint64_t x_transfer_id,
+                           name target, asset quantity, string memo, string data);
+
+        // reports a batch of incoming transactions by a single reporter, the issue limit is updated once for the whole batch
+        // can only be called by an existing reporter
+        ACTION reportbatch(name reporter, const vector<transfer_report>& reports);
+
         ACTION clearamount(uint64_t x_transfer_id); // closes row in amounts table, can only be called by bnt token contract or self
 
+        // removes up to max_rows expired transfers and up to max_rows expired amounts, can be called by anyone
+        // transfers expire TRANSFER_EXPIRATION seconds after their first report, amounts AMOUNT_EXPIRATION seconds after the issue
+        ACTION purge(uint32_t max_rows);
+
+        // gives the listed transfers and amounts that were stored before their report / issue time was tracked
+        // the current time, so they're indexed by it and expire like the other rows
+        // until then they're treated as expired, but purge can't find them
+        // can only be called by the contract account
+        ACTION migrate(const vector<uint64_t>& tx_ids, const vector<uint64_t>& x_transfer_ids);
+
         // transfer intercepts with standard transfer args
         // if the token received is the cross transfers token, initiates a cross transfer
         void transfer(name from, name to, asset quantity, string memo);
 
     private:
+        // memo fields point into the transfer memo
         struct memo_x_transfer {
-            std::string version;
-            std::string blockchain;
-            std::string target;
-            std::string x_transfer_id;
+            string_view version;
+            string_view blockchain;
+            string_view target;
+            string_view x_transfer_id;
         };
 
-        void xtransfer(string blockchain, name from, string target, asset quantity, std::string x_transfer_id);
+        void report(const vector<name>& signers, const vector<transfer_report>& reports);
+
+        // the hash of the canonical (packed) payload of a report, the reports of a transfer have to match it
+        checksum256 payload_hash(const transfer_report& report) {
+            auto packed = pack(report);
+            return sha256(packed.data(), packed.size());
+        }
+
+        uint64_t retired_mask();
+        void xtransfer(string_view blockchain, name from, string_view target, asset quantity, string_view x_transfer_id);
+        void purge_expired(uint32_t max_rows);
+
+        // version,blockchain,target[,x_transfer_id]
+        memo_x_transfer parse_memo(string_view memo) {
+            size_t fields = std::count(memo.begin(), memo.end(), ',') + 1;
+            eosio_assert(fields == 3 || fields == 4, "invalid memo format");
 
-        memo_x_transfer parse_memo(string memo) {
             auto res = memo_x_transfer();
-            auto parts = split(memo, ",");
-            res.version = parts[0];
-            res.blockchain = parts[1];
-            res.target = parts[2];
-            res.x_transfer_id = parts[3];
+            res.version = next_token(memo, ',');
+            res.blockchain = next_token(memo, ',');
+            res.target = next_token(memo, ',');
+            res.x_transfer_id = next_token(memo, ',');
+            eosio_assert(!res.blockchain.empty() && !res.target.empty(), "invalid memo format");
             return res;
         }
 };
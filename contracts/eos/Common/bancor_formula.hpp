@@ -0,0 +1,259 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+    Bancor Formula
+
+    Fixed-point implementation of the bancor conversion formulas, operating on
+    integer token amounts.
+
+    Powers with fractional exponents are computed as exp(ln(base) * exponent),
+    using the same building blocks as the solidity BancorFormula contract -
+    the argument is normalized into a small range with precomputed constants
+    and the remainder is approximated with a short series.
+    All values are unsigned fixed-point numbers with FORMULA_PRECISION fractional bits
+    and intermediate products are kept in 128 bits.
+
+    The header has no eosio dependencies other than the assertion, which can be
+    replaced by defining BANCOR_FORMULA_ASSERT before including it.
+*/
+
+#ifndef BANCOR_FORMULA_ASSERT
+#include <eosiolib/system.h>
+#define BANCOR_FORMULA_ASSERT(test, msg) eosio_assert(test, msg)
+#endif
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+#define FORMULA_PRECISION 60
+#define FIXED_1 ((uint128_t)1 << FORMULA_PRECISION)
+#define FIXED_LN2 ((uint128_t)0xb17217f7d1cf79b) // ln(2) * FIXED_1
+#define FIXED_INV_LN2 ((uint128_t)0x171547652b82fe17) // 1 / ln(2) * FIXED_1
+#define MAX_FORMULA_AMOUNT ((uint128_t)1 << 66)  // maximum base numerator and denominator
+
+// e ^ (1 / 2 ^ (i + 1)) * FIXED_1
+// used to reduce the log argument to [1, e ^ (1 / 256)) and to build the exp result
+static constexpr uint64_t FIXED_EXP_TABLE[] = {
+    0x1a61298e1e069bc9, // e ^ (1 / 2)
+    0x148b5e3c3e818667, // e ^ (1 / 4)
+    0x12216045b6f5ccfa, // e ^ (1 / 8)
+    0x11082b577d34ed7d, // e ^ (1 / 16)
+    0x108205601127ec99, // e ^ (1 / 32)
+    0x104080ab55de3918, // e ^ (1 / 64)
+    0x10202015600445b1, // e ^ (1 / 128)
+    0x10100802ab55777d  // e ^ (1 / 256)
+};
+
+// e ^ -(1 / 2 ^ (i + 1)) * FIXED_1, dividing by FIXED_EXP_TABLE[i] is replaced with a multiplication
+static constexpr uint64_t FIXED_INV_EXP_TABLE[] = {
+    0x09b4597e37cb04ff, // e ^ -(1 / 2)
+    0x0c75f7cf56410574, // e ^ -(1 / 4)
+    0x0e1eb51276c110c4, // e ^ -(1 / 8)
+    0x0f07d5fde38151e7, // e ^ -(1 / 16)
+    0x0f81fab5445aebc9, // e ^ -(1 / 32)
+    0x0fc07f55ff77d249, // e ^ -(1 / 64)
+    0x0fe01feab551127d, // e ^ -(1 / 128)
+    0x0ff007fd55ffdde4  // e ^ -(1 / 256)
+};
+#define FIXED_EXP_TABLE_SIZE 8
+
+// 1 / k * FIXED_1 for the odd terms of the log series, k = 3, 5, 7
+static constexpr uint64_t FIXED_LN_SERIES[] = {
+    0x0555555555555555,
+    0x0333333333333333,
+    0x0249249249249249
+};
+
+// 1 / k! * FIXED_1 for the terms of the exp series, k = 2 .. 7
+static constexpr uint64_t FIXED_EXP_SERIES[] = {
+    0x0800000000000000,
+    0x02aaaaaaaaaaaaab,
+    0x00aaaaaaaaaaaaab,
+    0x0022222222222222,
+    0x0005b05b05b05b06,
+    0x0000d00d00d00d01
+};
+
+// a power result, the value is mantissa * 2 ^ exponent / FIXED_1
+// the mantissa is in the range [FIXED_1, 2 * FIXED_1)
+struct fixed_power {
+    uint128_t mantissa;
+    int32_t   exponent;
+};
+
+// returns the index of the most significant bit, x must be positive
+inline uint32_t fixed_msb(uint128_t x) {
+    uint64_t hi = uint64_t(x >> 64);
+    if (hi)
+        return 127 - __builtin_clzll(hi);
+    return 63 - __builtin_clzll(uint64_t(x));
+}
+
+// returns ln(base_n / base_d) * FIXED_1, base_n must be at least base_d
+inline uint128_t fixed_ln(uint128_t base_n, uint128_t base_d) {
+    BANCOR_FORMULA_ASSERT(base_d > 0 && base_n >= base_d, "invalid formula base");
+    BANCOR_FORMULA_ASSERT(base_n < MAX_FORMULA_AMOUNT, "formula amount is too large");
+
+    // integer part of log2, the argument is normalized into [1, 2)
+    uint128_t x = (base_n << FORMULA_PRECISION) / base_d;
+    uint32_t msb = fixed_msb(x) - FORMULA_PRECISION;
+    x >>= msb;
+    uint128_t res = msb * FIXED_LN2;
+
+    // reduces the argument to [1, e ^ (1 / 256))
+    for (uint32_t i = 0; i < FIXED_EXP_TABLE_SIZE; ++i) {
+        if (x >= FIXED_EXP_TABLE[i]) {
+            x = (x * FIXED_INV_EXP_TABLE[i]) >> FORMULA_PRECISION;
+            res += FIXED_1 >> (i + 1);
+        }
+    }
+
+    // ln(x) = 2 * (z + z^3 / 3 + z^5 / 5 + z^7 / 7) where z = (x - 1) / (x + 1) < 2 ^ -9
+    uint128_t z = ((x - FIXED_1) << FORMULA_PRECISION) / (x + FIXED_1);
+    uint128_t z2 = (z * z) >> FORMULA_PRECISION;
+    uint128_t term = z;
+    uint128_t sum = z;
+    for (uint32_t k = 0; k < 3; ++k) {
+        term = (term * z2) >> FORMULA_PRECISION;
+        sum += (term * FIXED_LN_SERIES[k]) >> FORMULA_PRECISION;
+    }
+
+    return res + 2 * sum;
+}
+
+// results below 2 ^ -128, mul_power treats them as 0 (or the smallest unit when rounding up)
+#define FIXED_EXP_UNDERFLOW (fixed_power{ FIXED_1, -256 })
+
+// returns e ^ (x / FIXED_1)
+inline fixed_power fixed_exp(int128_t x) {
+    // e ^ x = 2 ^ n * e ^ r where 0 <= r < ln(2)
+    // n is estimated with a multiplication by 1 / ln(2) and corrected by at most a few steps
+    uint128_t abs_x = x < 0 ? -x : x;
+    if (x < 0 && abs_x >> 96)
+        return FIXED_EXP_UNDERFLOW;
+    BANCOR_FORMULA_ASSERT(abs_x >> 96 == 0, "formula result is out of range");
+    int128_t n = ((abs_x >> 30) * FIXED_INV_LN2) >> (2 * FORMULA_PRECISION - 30);
+    if (x < 0)
+        n = -n;
+
+    int128_t r = x - n * (int128_t)FIXED_LN2;
+    for (; r < 0; r += FIXED_LN2)
+        --n;
+    for (; r >= (int128_t)FIXED_LN2; r -= FIXED_LN2)
+        ++n;
+    if (n <= -128)
+        return FIXED_EXP_UNDERFLOW;
+    BANCOR_FORMULA_ASSERT(n < 128, "formula result is out of range");
+
+    // e ^ r = e ^ (sum of 1 / 2 ^ (i + 1)) * e ^ remainder where remainder < 2 ^ -8
+    // the terms of the sum are the top fractional bits of r
+    uint128_t rem = r;
+    uint128_t res = FIXED_1;
+    for (uint32_t i = 0; i < FIXED_EXP_TABLE_SIZE; ++i) {
+        bool take = (rem >> (FORMULA_PRECISION - 1 - i)) & 1;
+        res = (res * (take ? FIXED_EXP_TABLE[i] : uint64_t(FIXED_1))) >> FORMULA_PRECISION;
+    }
+    rem &= (FIXED_1 >> FIXED_EXP_TABLE_SIZE) - 1;
+
+    // e ^ remainder = 1 + remainder + remainder^2 / 2! + ... + remainder^7 / 7!
+    uint128_t term = rem;
+    uint128_t sum = FIXED_1 + rem;
+    for (uint32_t k = 0; k < 6; ++k) {
+        term = (term * rem) >> FORMULA_PRECISION;
+        sum += (term * FIXED_EXP_SERIES[k]) >> FORMULA_PRECISION;
+    }
+    res = (res * sum) >> FORMULA_PRECISION;
+
+    // keeps the mantissa normalized in case of rounding at the upper bound
+    if (res >= 2 * FIXED_1) {
+        res >>= 1;
+        ++n;
+    }
+
+    return fixed_power{ res, int32_t(n) };
+}
+
+// returns (base_n / base_d) ^ (exp_n / exp_d), base_n must be at least base_d
+inline fixed_power power(uint128_t base_n, uint128_t base_d, uint64_t exp_n, uint64_t exp_d) {
+    BANCOR_FORMULA_ASSERT(exp_d > 0, "invalid formula exponent");
+    uint128_t ln = fixed_ln(base_n, base_d);
+    return fixed_exp(ln * exp_n / exp_d);
+}
+
+// returns amount * p, rounded down or up
+inline uint128_t mul_power(uint64_t amount, fixed_power p, bool round_up = false) {
+    uint128_t product = amount * p.mantissa;
+    int32_t shift = FORMULA_PRECISION - p.exponent;
+    if (shift >= 128)
+        return round_up && product > 0 ? 1 : 0;
+
+    BANCOR_FORMULA_ASSERT(shift >= 0, "formula result is out of range");
+    uint128_t res = product >> shift;
+    if (round_up && (res << shift) != product)
+        ++res;
+    return res;
+}
+
+// converts a formula result to a token amount
+inline int64_t to_amount(uint128_t value) {
+    BANCOR_FORMULA_ASSERT(value <= (uint128_t)INT64_MAX, "formula result is out of range");
+    return int64_t(value);
+}
+
+// given a token supply, reserve balance, ratio and a input amount (in the reserve token),
+// calculates the return for a given conversion (in the main token)
+// the balance is expected to include the deposit amount
+inline int64_t calculate_purchase_return(int64_t balance, int64_t deposit_amount, int64_t supply, uint64_t ratio) {
+    BANCOR_FORMULA_ASSERT(balance > 0 && deposit_amount >= 0 && supply > 0, "invalid formula input");
+
+    // supply * ((1 + deposit / balance) ^ (ratio / 1000) - 1)
+    auto p = power((uint128_t)balance + deposit_amount, balance, ratio, 1000);
+    return to_amount(mul_power(supply, p) - supply);
+}
+
+// given a token supply, reserve balance, ratio and a input amount (in the main token),
+// calculates the return for a given conversion (in the reserve token)
+inline int64_t calculate_sale_return(int64_t balance, int64_t sell_amount, int64_t supply, uint64_t ratio) {
+    BANCOR_FORMULA_ASSERT(balance >= 0 && sell_amount >= 0 && supply > sell_amount, "invalid formula input");
+
+    // balance * ((1 + sell / (supply - sell)) ^ (1000 / ratio) - 1)
+    auto p = power(supply, supply - sell_amount, 1000, ratio);
+    return to_amount(mul_power(balance, p) - balance);
+}
+
+// converts between two reserves with equal ratios
+inline int64_t quick_convert(int64_t balance, int64_t in, int64_t to_balance) {
+    BANCOR_FORMULA_ASSERT(balance >= 0 && in > 0 && to_balance >= 0, "invalid formula input");
+    return to_amount((uint128_t)in * to_balance / ((uint128_t)balance + in));
+}
+
+// given two reserve balances, their ratios and a input amount (in the 'from' reserve token),
+// calculates the return for a conversion between the reserves (in the 'to' reserve token)
+// equivalent to purchasing smart tokens with one reserve and selling them for the other,
+// with a single power evaluation
+inline int64_t calculate_cross_reserve_return(int64_t from_balance, uint64_t from_ratio, int64_t to_balance, uint64_t to_ratio, int64_t amount) {
+    BANCOR_FORMULA_ASSERT(from_balance > 0 && to_balance >= 0 && amount > 0 && from_ratio > 0 && to_ratio > 0, "invalid formula input");
+    if (from_ratio == to_ratio)
+        return quick_convert(from_balance, amount, to_balance);
+
+    // to_balance * (1 - (from_balance / (from_balance + amount)) ^ (from_ratio / to_ratio))
+    // the subtracted part is rounded up so that the return is rounded down
+    uint128_t ln = fixed_ln((uint128_t)from_balance + amount, from_balance);
+    auto p = fixed_exp(-int128_t(ln * from_ratio / to_ratio));
+    return to_amount(to_balance - mul_power(to_balance, p, true));
+}
+
+// returns the amount left after deducting a fee (in 1/1000 units) the given number of times,
+// e.g. twice for a conversion between two reserves which goes through the smart token
+inline int64_t deduct_fee(int64_t amount, uint64_t fee, uint32_t magnitude) {
+    BANCOR_FORMULA_ASSERT(amount >= 0 && fee <= 1000, "invalid formula input");
+    uint128_t n = amount;
+    uint128_t d = 1;
+    for (uint32_t i = 0; i < magnitude; ++i) {
+        n *= 1000 - fee;
+        d *= 1000;
+    }
+    return to_amount(n / d);
+}
@@ -6,71 +6,252 @@
 #include <eosiolib/symbol.hpp>
 
 #include <string>
-#include <vector>
-#include <iterator>
-#include <math.h>
+#include <string_view>
+#include <algorithm>
 #include "events.hpp"
 
 using std::string;
+using std::string_view;
 using std::vector;
 
 using namespace eosio;
 
-typedef vector<string> path;
+#define BANCOR_X "bancorxoneos"_n
+#define BANCOR_NETWORK "thisisbancor"_n
+#define BNT_TOKEN "bntbntbntbnt"_n
+
+#define MAX_PATH_HOPS 16 // maximum number of conversion steps a single memo can describe
+
+// conversion memo versions
+// 1    version,path,minimum return,target account[;receiver memo]
+//      each converter forwards the memo without the step it performed
+// 1.1  version,hop,path,minimum return,target account[;receiver memo]
+//      the path is forwarded as is and hop is the index of the next conversion step
+// 2    version,payload[;receiver memo]
+//      payload is the base64 encoding of the little endian binary structure -
+//      uint8 hop, uint8 hop count, hop count x (uint64 converter name, uint64 'to' symbol code),
+//      int64 minimum return (in the smallest unit of the target token), uint64 target account name
+//      the path is forwarded as is and only the hop byte is advanced
+#define MEMO_VERSION "1"
+#define MEMO_VERSION_HOP_CURSOR "1.1"
+#define MEMO_VERSION_PACKED "2"
+
+#define MAX_PACKED_MEMO_SIZE (2 + 16 * MAX_PATH_HOPS + 16)
+
+#define MAX_PRECISION 18 // maximum token precision
+
+// 10 ^ i for every token precision
+static constexpr int64_t POWERS_OF_10[MAX_PRECISION + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+    10000000000, 100000000000, 1000000000000, 10000000000000, 100000000000000,
+    1000000000000000, 10000000000000000, 100000000000000000, 1000000000000000000
+};
+
+// parses a decimal number, e.g. 12.5, into an amount in the smallest unit of a token with the given precision
+// fractional digits beyond the precision are truncated
+inline int64_t parse_decimal_amount(string_view str, uint8_t precision) {
+    eosio_assert(precision <= MAX_PRECISION, "invalid precision");
+
+    uint64_t integer = 0;
+    uint64_t fraction = 0;
+    uint8_t fraction_digits = 0;
+    bool point_seen = false;
+    for (char c : str) {
+        if (c == '.' && !point_seen) {
+            point_seen = true;
+            continue;
+        }
+
+        eosio_assert(c >= '0' && c <= '9', "invalid decimal amount");
+        if (!point_seen) {
+            // checked before multiplying, so the integer part can't wrap around
+            eosio_assert(integer <= (uint64_t(INT64_MAX / POWERS_OF_10[precision]) - (c - '0')) / 10, "decimal amount is too large");
+            integer = integer * 10 + (c - '0');
+        }
+        else if (fraction_digits < precision) {
+            fraction = fraction * 10 + (c - '0');
+            ++fraction_digits;
+        }
+    }
+
+    uint64_t amount = integer * POWERS_OF_10[precision] + fraction * POWERS_OF_10[precision - fraction_digits];
+    eosio_assert(amount <= uint64_t(INT64_MAX), "decimal amount is too large");
+    return amount;
+}
 
+// a single conversion step - converter account and 'to' token symbol
+// text values point into the memo and are only decoded when requested,
+// packed memos carry the encoded values instead
+struct memo_hop {
+    string_view converter;
+    string_view to_symbol;
+    uint64_t    converter_raw = 0;
+    uint64_t    to_symbol_raw = 0;
+
+    name converter_name() const { return converter.empty() ? name(converter_raw) : name(converter); }
+    symbol_code to_symbol_code() const { return to_symbol.empty() ? symbol_code(to_symbol_raw) : symbol_code(to_symbol); }
+};
+
+// parsed conversion memo, all fields point into the memo string it was parsed from
+// so the memo must outlive the structure
 struct memo_structure {
-    path           path;
-    vector<name>   converters;   
-    string         version;
-    string         min_return;
-    string         dest_account;
-    string         receiver_memo;
+    string_view version;
+    string_view cursor;         // text holding the hop index, empty for version 1 memos
+    memo_hop    hops[MAX_PATH_HOPS];
+    uint8_t     hop_count = 0;
+    uint8_t     hop = 0;        // index of the conversion step the memo is at
+    string_view min_return;
+    string_view dest_account;
+    string_view receiver_memo;
+    bool        packed = false; // true for version 2 memos, which carry the values below instead of text
+    int64_t     min_return_amount = 0;
+    uint64_t    dest_account_raw = 0;
+
+    const memo_hop& current_hop() const { return hops[hop]; }
+    uint8_t remaining_hops() const { return hop_count - hop; }
+    name destination() const { return packed ? name(dest_account_raw) : name(dest_account); }
+    int64_t min_return_units(uint8_t precision) const { return packed ? min_return_amount : parse_decimal_amount(min_return, precision); }
 };
 
-#define BANCOR_X "bancorxoneos"_n
-#define BANCOR_NETWORK "thisisbancor"_n
-#define BNT_TOKEN "bntbntbntbnt"_n
+// splits the text up to the next delimiter off the front of str
+inline string_view next_token(string_view& str, char delim) {
+    size_t pos = str.find(delim);
+    string_view token = str.substr(0, pos);
+    str.remove_prefix(pos == string_view::npos ? str.size() : pos + 1);
+    return token;
+}
+
+inline int8_t base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
 
-vector<string> split(const string& str, const string& delim)
-{
-    vector<string> tokens;
-    size_t prev = 0, pos = 0;
-
-    do
-    {
-        pos = str.find(delim, prev);
-        if (pos == string::npos) pos = str.length();
-        string token = str.substr(prev, pos-prev);
-        tokens.push_back(token);
-        prev = pos + delim.length();
+inline char base64_char(uint8_t value) {
+    return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[value & 0x3F];
+}
+
+// decodes base64 text into out, padding is optional
+// returns the number of bytes written
+inline size_t base64_decode(string_view in, uint8_t* out, size_t max_size) {
+    while (!in.empty() && in.back() == '=')
+        in.remove_suffix(1);
+    eosio_assert(in.size() % 4 != 1, "invalid memo format");
+    eosio_assert(in.size() * 3 / 4 <= max_size, "conversion path is too long");
+
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
+    size_t size = 0;
+    for (char c : in) {
+        int8_t value = base64_value(c);
+        eosio_assert(value >= 0, "invalid memo format");
+        bits = (bits << 6) | value;
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            out[size++] = (bits >> bit_count) & 0xFF;
+        }
     }
-    while (pos < str.length() && prev < str.length());
-    return tokens;
+    return size;
 }
 
-path parse_memo_path(std::string memo) {
-    size_t pos = memo.find(",", 2); // get the position of first comma after memo version
-    std::string path = memo.substr(2, pos);
-    auto path_elements = split(path, " ");
-    if (path_elements.size() == 1 && path_elements[0] == "") {
-        return {};
+inline uint64_t read_uint64(const uint8_t* data) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+// reads the binary payload of a version 2 memo into res
+inline void parse_packed_memo(memo_structure& res, string_view payload) {
+    uint8_t data[MAX_PACKED_MEMO_SIZE];
+    size_t size = base64_decode(payload, data, sizeof(data));
+    eosio_assert(size >= 2 && data[1] <= MAX_PATH_HOPS, "invalid memo format");
+    eosio_assert(size == 2 + 16 * data[1] + 16, "invalid memo format");
+
+    res.packed = true;
+    res.cursor = payload.substr(0, 4); // the base64 quad holding the hop byte
+    res.hop = data[0];
+    res.hop_count = data[1];
+
+    const uint8_t* pos = data + 2;
+    for (uint8_t i = 0; i < res.hop_count; i++, pos += 16) {
+        res.hops[i].converter_raw = read_uint64(pos);
+        res.hops[i].to_symbol_raw = read_uint64(pos + 8);
     }
-    else
-        return path_elements;
+    res.min_return_amount = static_cast<int64_t>(read_uint64(pos));
+    res.dest_account_raw = read_uint64(pos + 8);
 }
 
-std::string build_memo(memo_structure data) {
-    std::string pathstr = "";
-    for(auto i=0; i < data.path.size(); i++){
-        if(i != 0)
-            pathstr.append(" ");
-        pathstr.append(data.path[i]);
+// reads a space delimited conversion path into the steps of res
+inline void parse_path(memo_structure& res, string_view path) {
+    while (!path.empty()) {
+        eosio_assert(res.hop_count < MAX_PATH_HOPS, "conversion path is too long");
+        memo_hop& hop = res.hops[res.hop_count++];
+        hop.converter = next_token(path, ' ');
+        eosio_assert(!path.empty(), "invalid memo format");
+        hop.to_symbol = next_token(path, ' ');
+    }
+}
+
+// parses the memo in a single pass without copying it
+// see MEMO_VERSION for the supported formats
+inline memo_structure parse_memo(string_view memo) {
+    memo_structure res;
+    string_view conversion = next_token(memo, ';'); // we separate concantenated memos with ";"
+    res.receiver_memo = memo.empty() ? string_view("convert") : memo; // default memo for receiver account
+
+    size_t fields = std::count(conversion.begin(), conversion.end(), ',') + 1;
+    res.version = next_token(conversion, ',');
+    if (res.version == MEMO_VERSION_PACKED) {
+        eosio_assert(fields == 2, "invalid memo format");
+        parse_packed_memo(res, conversion);
+        eosio_assert(res.hop < res.hop_count, "invalid memo format");
+        return res;
     }
 
-    std::string memo = "";
+    eosio_assert(fields >= 4, "invalid memo format");
+    if (res.version == MEMO_VERSION_HOP_CURSOR) {
+        eosio_assert(fields >= 5, "invalid memo format");
+        res.cursor = next_token(conversion, ',');
+        eosio_assert(!res.cursor.empty() && res.cursor.size() <= 2, "invalid memo format");
+        for (char c : res.cursor) {
+            eosio_assert(c >= '0' && c <= '9', "invalid memo format");
+            res.hop = res.hop * 10 + (c - '0');
+        }
+    }
+
+    string_view path = next_token(conversion, ',');
+    res.min_return = next_token(conversion, ',');
+    res.dest_account = next_token(conversion, ',');
+
+    parse_path(res, path);
+    eosio_assert(res.hop < res.hop_count, "invalid memo format");
+
+    return res;
+}
+
+// builds the memo for the conversion step at first_hop, in the same format parse_memo accepts
+// the result is allocated once and filled directly from the parsed memo views
+inline string build_memo(const memo_structure& data, uint8_t first_hop) {
+    size_t size = data.version.size() + data.min_return.size() + data.dest_account.size() + data.receiver_memo.size() + 4;
+    for (uint8_t i = first_hop; i < data.hop_count; i++)
+        size += data.hops[i].converter.size() + data.hops[i].to_symbol.size() + 2;
+
+    string memo;
+    memo.reserve(size);
     memo.append(data.version);
     memo.append(",");
-    memo.append(pathstr);
+    for (uint8_t i = first_hop; i < data.hop_count; i++) {
+        if (i != first_hop)
+            memo.append(" ");
+        memo.append(data.hops[i].converter);
+        memo.append(" ");
+        memo.append(data.hops[i].to_symbol);
+    }
     memo.append(",");
     memo.append(data.min_return);
     memo.append(",");
@@ -80,46 +261,68 @@ std::string build_memo(memo_structure data) {
     return memo;
 }
 
-double to_fixed(double num, int precision) {
-    return (int)(num * pow(10, precision)) / pow(10, precision);
+inline void write_uint64(uint8_t* data, uint64_t value) {
+    for (int i = 0; i < 8; i++, value >>= 8)
+        data[i] = value & 0xFF;
 }
 
-memo_structure parse_memo(std::string memo) {
-    auto res = memo_structure();
-    auto split_memos = split(memo, ";"); // we separate concantenated memos with ";"
-    auto parts = split(split_memos[0], ","); // split the first memo by ","
-
-    res.version = parts[0];
-
-    auto path_elements = split(parts[1], " ");
-
-    if (path_elements.size() == 1 && path_elements[0] == "") {
-        res.path = {};
-    } else
-        res.path = path_elements;
-
-    res.converters = {};
-    for (int i = 0; i < res.path.size(); i += 2)
-        res.converters.push_back(name(res.path[i].c_str()));
+// builds a version 2 memo for the steps of data starting at its current hop,
+// with the given minimum return (in the smallest unit of the target token) and target account
+inline string build_packed_memo(const memo_structure& data, int64_t min_return, name dest_account) {
+    uint8_t bytes[MAX_PACKED_MEMO_SIZE];
+    size_t size = 0;
+    bytes[size++] = 0;
+    bytes[size++] = data.remaining_hops();
+    for (uint8_t i = data.hop; i < data.hop_count; i++, size += 16) {
+        write_uint64(bytes + size, data.hops[i].converter_name().value);
+        write_uint64(bytes + size + 8, data.hops[i].to_symbol_code().raw());
+    }
+    write_uint64(bytes + size, static_cast<uint64_t>(min_return));
+    write_uint64(bytes + size + 8, dest_account.value);
+    size += 16;
 
-    if (split_memos.size() == 2) {
-        res.receiver_memo = split_memos[1];
-    } else
-        res.receiver_memo = "convert"; // default memo for receiver account
+    string memo(MEMO_VERSION_PACKED ",");
+    memo.reserve(memo.size() + (size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t bits = bytes[i] << 16;
+        if (i + 1 < size) bits |= bytes[i + 1] << 8;
+        if (i + 2 < size) bits |= bytes[i + 2];
+        memo.push_back(base64_char(bits >> 18));
+        memo.push_back(base64_char(bits >> 12));
+        memo.push_back(i + 1 < size ? base64_char(bits >> 6) : '=');
+        memo.push_back(i + 2 < size ? base64_char(bits) : '=');
+    }
+    return memo;
+}
 
-    res.min_return = parts[2];
-    res.dest_account = parts[3];
+// returns the memo to forward to the next conversion step
+// version 1 memos are rebuilt without the current step, newer versions only advance the hop cursor
+inline string next_hop(string_view memo, const memo_structure& data) {
+    if (data.cursor.empty())
+        return build_memo(data, data.hop + 1);
 
-    return res;
-}
+    uint8_t next = data.hop + 1;
+    size_t cursor_pos = data.cursor.data() - memo.data();
+    string_view suffix = memo.substr(cursor_pos + data.cursor.size());
 
-memo_structure next_hop(memo_structure data){
-    auto res = memo_structure();
-    res.path = std::vector<std::string>(data.path);
-    res.path.erase(res.path.begin(), res.path.begin() + 2);
-    res.version = data.version;
-    res.min_return = data.min_return;
-    res.dest_account = data.dest_account;
-    res.receiver_memo = data.receiver_memo;
+    string res;
+    res.reserve(memo.size() + 1);
+    res.append(memo.substr(0, cursor_pos));
+    if (data.packed) {
+        // the hop byte is the first byte of the payload, so only the first base64 quad changes
+        uint8_t bytes[3];
+        base64_decode(data.cursor, bytes, sizeof(bytes));
+        bytes[0] = next;
+        res.push_back(base64_char(bytes[0] >> 2));
+        res.push_back(base64_char((bytes[0] << 4) | (bytes[1] >> 4)));
+        res.push_back(base64_char((bytes[1] << 2) | (bytes[2] >> 6)));
+        res.push_back(base64_char(bytes[2]));
+    }
+    else {
+        if (next >= 10)
+            res.push_back('0' + next / 10);
+        res.push_back('0' + next % 10);
+    }
+    res.append(suffix);
     return res;
 }
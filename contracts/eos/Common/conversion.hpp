@@ -0,0 +1,67 @@
+#pragma once
+
+#include "bancor_formula.hpp"
+
+/*
+    Conversion Step
+
+    Calculates a single conversion step of a converter - the purchase, sale or cross reserve
+    return and the conversion fee - from plain integer values.
+    BancorConverter uses it for conversions and BancorNetwork for path calculations and quotes,
+    and like the formula header it compiles outside of a contract.
+*/
+
+// a reserve of a converter, or the converter's smart token, as seen by a conversion step
+struct conversion_token {
+    int64_t  balance;   // converter balance including the virtual balance, unused for the smart token
+    uint64_t ratio;     // reserve ratio, 0-1000, unused for the smart token
+    bool     smart;     // true for the converter's smart token
+};
+
+// the result of a single conversion step
+struct conversion_result {
+    int64_t to_amount;      // conversion return, after the fee
+    int64_t fee_amount;     // conversion fee, in the 'to' token
+    int64_t smart_supply;   // smart token supply after the conversion, including the virtual amount
+    int64_t from_balance;   // 'from' reserve balance before the conversion, including the virtual amount
+    int64_t to_balance;     // 'to' reserve balance after the conversion, including the virtual amount
+};
+
+// converts amount of the 'from' token to the 'to' token
+// the 'from' balance shouldn't include the converted amount, fee is a percentage, 0-1000
+inline conversion_result calculate_conversion(const conversion_token& from, const conversion_token& to, int64_t smart_supply, uint64_t fee, int64_t amount) {
+    conversion_result result;
+    result.from_balance = from.balance;
+    result.to_balance = to.balance;
+    result.smart_supply = smart_supply;
+
+    int64_t to_amount = 0;
+    uint32_t fee_magnitude = 1;
+    if (from.smart) {
+        result.smart_supply -= amount;
+        to_amount = calculate_sale_return(to.balance, amount, result.smart_supply, to.ratio);
+    }
+    else if (to.smart) {
+        to_amount = calculate_purchase_return(from.balance + amount, amount, smart_supply, from.ratio);
+    }
+    else {
+        // conversion between two reserves, the fee is taken for both the purchase and the sale
+        to_amount = calculate_cross_reserve_return(from.balance, from.ratio, to.balance, to.ratio, amount);
+        fee_magnitude = 2;
+    }
+
+    result.fee_amount = 0;
+    if (fee > 0) {
+        int64_t final_amount = deduct_fee(to_amount, fee, fee_magnitude);
+        result.fee_amount = to_amount - final_amount;
+        to_amount = final_amount;
+    }
+
+    result.to_amount = to_amount;
+    if (to.smart)
+        result.smart_supply += to_amount;
+    else
+        result.to_balance -= to_amount;
+
+    return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <eosiolib/action.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/asset.hpp>
+#include <eosiolib/datastream.hpp>
+
+#define TRANSFER_PREFIX_SIZE 32 // from, to and quantity (amount and symbol), the memo follows them
+
+// the fixed size start of a token transfer action
+struct transfer_prefix {
+    eosio::name  from;
+    eosio::name  to;
+    eosio::asset quantity;
+};
+
+// reads the start of a transfer action without reading or deserializing the memo
+inline transfer_prefix read_transfer_prefix() {
+    char data[TRANSFER_PREFIX_SIZE];
+    eosio_assert(action_data_size() >= TRANSFER_PREFIX_SIZE, "invalid transfer data");
+    read_action_data(data, TRANSFER_PREFIX_SIZE);
+
+    transfer_prefix res;
+    eosio::datastream<const char*> ds(data, TRANSFER_PREFIX_SIZE);
+    ds >> res.from >> res.to >> res.quantity;
+    return res;
+}
+
+// returns true if a transfer notification is a transfer to the receiver from another account
+// notifications of outgoing transfers and of transfers between other accounts can be dropped
+// before the action is deserialized
+inline bool is_incoming_transfer(uint64_t receiver) {
+    auto transfer = read_transfer_prefix();
+    return transfer.to.value == receiver && transfer.from.value != receiver;
+}
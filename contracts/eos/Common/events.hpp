@@ -1,32 +1,180 @@
-using eosio::print;
-
-#define EVENTKV(key, value) \
-{ \
-    print('"'); \
-    print(key); \
-    print('"'); \
-    print(':'); \
-    print('"'); \
-    print(value); \
-    print('"'); \
-    print(",");\
-} while(0);
-
-#define EVENTKVL(key, value) \
-{ \
-    print('"'); \
-    print(key); \
-    print('"'); \
-    print(':'); \
-    print('"'); \
-    print(value); \
-    print('"'); \
-} while(0);
-
-#define START_EVENT(etype, version) \
-    print("{"); \
-    EVENTKV("version",version) \
-    EVENTKV("etype",etype) 
-
-#define END_EVENT() \
-    print("}\n");
+#pragma once
+
+#include <eosiolib/print.h>
+#include <eosiolib/name.hpp>
+#include <eosiolib/symbol.hpp>
+#include <eosiolib/asset.hpp>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
+
+#define EVENT_BUFFER_SIZE 512 // events longer than this are printed in more than one chunk
+
+// an amount of token units printed as a plain decimal number, e.g. { 15000, 4 } prints 1.5
+struct decimal_amount {
+    int64_t amount;
+    uint8_t precision;
+};
+
+/*
+    Formats a single line json event into a stack buffer and prints it with one call.
+
+    Every value is written as a quoted string, in the order it is added:
+    {"version":"<version>","etype":"<etype>","<key>":"<value>",...}\n
+
+    Values are written as is and are not escaped.
+*/
+class event_writer {
+    public:
+        event_writer(const char* etype, const char* version) {
+            write('{');
+            kv("version", version);
+            kv("etype", etype);
+        }
+
+        event_writer& kv(const char* key, std::string_view value) {
+            begin_value(key);
+            write(value.data(), value.size());
+            return end_value();
+        }
+
+        event_writer& kv(const char* key, eosio::name value) {
+            static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+            char str[13];
+            uint64_t tmp = value.value;
+            for (uint32_t i = 0; i <= 12; ++i) {
+                str[12 - i] = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+                tmp >>= (i == 0 ? 4 : 5);
+            }
+
+            uint32_t len = 13;
+            while (len > 0 && str[len - 1] == '.')
+                --len;
+
+            begin_value(key);
+            write(str, len);
+            return end_value();
+        }
+
+        event_writer& kv(const char* key, eosio::symbol_code value) {
+            begin_value(key);
+            for (uint64_t sym = value.raw(); sym; sym >>= 8)
+                write(char(sym & 0xff));
+            return end_value();
+        }
+
+        event_writer& kv(const char* key, uint64_t value) {
+            begin_value(key);
+            write_uint(value);
+            return end_value();
+        }
+
+        // same output as asset::print, e.g. 1.5000 TKN
+        event_writer& kv(const char* key, const eosio::asset& value) {
+            uint8_t precision = value.symbol.precision();
+            begin_value(key);
+            write_fixed(value.amount, precision, false);
+            if (precision == 0)
+                write('.');
+            write(' ');
+            for (uint64_t sym = value.symbol.code().raw(); sym; sym >>= 8)
+                write(char(sym & 0xff));
+            return end_value();
+        }
+
+        // trailing fractional zeros are dropped, e.g. 0.5 rather than 0.5000
+        event_writer& kv(const char* key, decimal_amount value) {
+            begin_value(key);
+            write_fixed(value.amount, value.precision, true);
+            return end_value();
+        }
+
+        void end() {
+            write("}\n", 2);
+            flush();
+        }
+
+    private:
+        char     buffer[EVENT_BUFFER_SIZE];
+        uint32_t size = 0;
+        bool     first = true;
+
+        void flush() {
+            if (size > 0)
+                prints_l(buffer, size);
+            size = 0;
+        }
+
+        void write(char c) {
+            if (size == EVENT_BUFFER_SIZE)
+                flush();
+            buffer[size++] = c;
+        }
+
+        void write(const char* data, size_t len) {
+            while (len > 0) {
+                if (size == EVENT_BUFFER_SIZE)
+                    flush();
+
+                size_t chunk = std::min(len, size_t(EVENT_BUFFER_SIZE - size));
+                memcpy(buffer + size, data, chunk);
+                size += chunk;
+                data += chunk;
+                len -= chunk;
+            }
+        }
+
+        void write_uint(uint64_t value) {
+            char digits[20];
+            uint32_t len = 0;
+            do {
+                digits[sizeof(digits) - ++len] = '0' + value % 10;
+                value /= 10;
+            } while (value);
+            write(digits + sizeof(digits) - len, len);
+        }
+
+        void write_fixed(int64_t amount, uint8_t precision, bool trim) {
+            uint64_t magnitude = amount < 0 ? 0 - uint64_t(amount) : uint64_t(amount);
+            if (amount < 0)
+                write('-');
+
+            uint64_t p10 = 1;
+            for (uint8_t p = 0; p < precision; ++p)
+                p10 *= 10;
+
+            write_uint(magnitude / p10);
+
+            uint64_t fraction = magnitude % p10;
+            if (precision == 0 || (trim && fraction == 0))
+                return;
+
+            char digits[20];
+            uint32_t len = precision;
+            for (uint32_t i = len; i > 0; --i) {
+                digits[i - 1] = '0' + fraction % 10;
+                fraction /= 10;
+            }
+            if (trim)
+                while (digits[len - 1] == '0')
+                    --len;
+
+            write('.');
+            write(digits, len);
+        }
+
+        void begin_value(const char* key) {
+            if (!first)
+                write(',');
+            first = false;
+
+            write('"');
+            write(key, strlen(key));
+            write("\":\"", 3);
+        }
+
+        event_writer& end_value() {
+            write('"');
+            return *this;
+        }
+};
@@ -10,11 +10,11 @@ using std::string;
 // events
 // triggered when an account reroutes an xtransfer transaction
 #define EMIT_TX_REROUTE_EVENT(tx_id, blockchain, target) \
-    START_EVENT("txreroute", "1.1") \
-    EVENTKV("tx_id",tx_id) \
-    EVENTKV("blockchain",blockchain) \
-    EVENTKVL("target",target) \
-    END_EVENT()
+    event_writer("txreroute", "1.1") \
+        .kv("tx_id", tx_id) \
+        .kv("blockchain", blockchain) \
+        .kv("target", target) \
+        .end();
 
 /*
     the XTransferRerouter contract allows rerouting transactions that were
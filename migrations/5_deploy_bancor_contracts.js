@@ -63,6 +63,14 @@ async function regConverter(deployer, token, symbol, fee, networkContract, netwo
         quantity: `100000.0000000000 ${networkTokenSymbol}`,
         memo: "setup"
     }, { authorization: `${issuerAccount}@active`, broadcast: true, sign: true, keyProvider: issuerPrivateKey });
+
+    // the smart token was issued directly to the converter, sync its tracked supply
+    await converter.contractInstance.resync({}, { authorization: `${converter.contract.address}@active`, broadcast: true, sign: true });
+
+    // only the network can add converters to its registry
+    await networkContract.contractInstance.regconverter({
+        converter: converter.contract.address
+    }, { authorization: `${networkContract.contract.address}@active`, broadcast: true, sign: true });
 }
 
 module.exports = async function(deployer, network, accounts) {
@@ -159,6 +167,17 @@ module.exports = async function(deployer, network, accounts) {
         keyProvider: converter.keys.privateKey
     });
 
+    // sync the BNTEOS supply tracked by the converter
+    await converter.contractInstance.resync({}, {
+        authorization: `${converter.account}@active`
+    });
+
+    // register the BNTEOS converter in the network
+    await networkContract.contractInstance.regconverter({
+        converter: converter.account
+    }, {
+        authorization: `${networkContract.account}@active`
+    });
 
     // initialize bancorx
     await bancorxContract.contractInstance.init({
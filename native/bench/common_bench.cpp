@@ -0,0 +1,246 @@
+/*
+    Benchmarks the memo handling of Common/common.hpp and the conversion math, built for the host
+    with the stub eosio headers in native/stubs.
+
+    common_bench            prints ns/op and heap allocations/op of every case
+    common_bench --check    only verifies the memo round trips, exits with 1 on failure
+
+    Memos have 1 to 10 hops, in every memo version, with and without a long receiver memo.
+*/
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#define BANCOR_FORMULA_ASSERT(test, msg) if (!(test)) throw std::runtime_error(msg)
+#include "common.hpp"
+#include "conversion.hpp"
+
+// heap allocations made by the process, counted by the global operator new
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// keeps the compiler from optimizing a benchmarked result away
+template<typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// hides a value from the optimizer, so calculations on constants aren't folded
+template<typename T>
+inline T opaque(T value) {
+    asm volatile("" : "+r"(value));
+    return value;
+}
+
+struct bench_result {
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+template<typename F>
+bench_result measure(size_t iterations, F f) {
+    f(); // warm up
+    size_t start_allocations = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f();
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return { elapsed / iterations, double(allocations - start_allocations) / iterations };
+}
+
+void report(const char* name, bench_result res) {
+    printf("%-40s %10.1f %10.2f\n", name, res.ns_per_op, res.allocs_per_op);
+}
+
+// a conversion path through hops converters, ending in the TKNB token
+std::string make_path(size_t hops) {
+    std::string path;
+    for (size_t i = 0; i < hops; ++i) {
+        if (i > 0)
+            path += ' ';
+        path += "cnvtconvert" + std::string(1, char('a' + i));
+        path += i + 1 == hops ? " TKNB" : i % 2 == 0 ? " BNT" : " TKNA";
+    }
+    return path;
+}
+
+// a version 1 or 1.1 memo, optionally followed by a receiver memo
+std::string make_memo(const char* version, size_t hops, const std::string& receiver_memo) {
+    std::string memo = version;
+    memo += ',';
+    if (strcmp(version, MEMO_VERSION_HOP_CURSOR) == 0)
+        memo += "0,";
+    memo += make_path(hops) + ",0.00000001,receiveracct";
+    if (!receiver_memo.empty())
+        memo += ';' + receiver_memo;
+    return memo;
+}
+
+std::string make_packed_memo(size_t hops, const std::string& receiver_memo) {
+    std::string text = make_memo(MEMO_VERSION, hops, "");
+    std::string memo = build_packed_memo(parse_memo(text), 1, "receiveracct"_n);
+    if (!receiver_memo.empty())
+        memo += ';' + receiver_memo;
+    return memo;
+}
+
+// follows a memo through every hop, the way each converter forwards it
+// returns the converters in the order the memo reached them
+std::vector<name> follow(std::string memo) {
+    std::vector<name> res;
+    while (true) {
+        auto data = parse_memo(memo);
+        if (data.remaining_hops() == 0)
+            break;
+        res.push_back(data.current_hop().converter_name());
+        if (data.remaining_hops() == 1)
+            break;
+        memo = next_hop(memo, data);
+    }
+    return res;
+}
+
+bool check() {
+    bool ok = true;
+    auto expect = [&](bool test, const char* msg) {
+        if (!test) {
+            printf("FAILED: %s\n", msg);
+            ok = false;
+        }
+    };
+
+    std::string receiver_memo(200, 'x');
+    for (size_t hops = 1; hops <= 10; ++hops) {
+        std::vector<name> expected;
+        for (size_t i = 0; i < hops; ++i)
+            expected.push_back(name("cnvtconvert" + std::string(1, char('a' + i))));
+
+        expect(follow(make_memo(MEMO_VERSION, hops, receiver_memo)) == expected, "version 1 path");
+        expect(follow(make_memo(MEMO_VERSION_HOP_CURSOR, hops, "")) == expected, "version 1.1 path");
+        expect(follow(make_packed_memo(hops, receiver_memo)) == expected, "version 2 path");
+
+        auto text = make_memo(MEMO_VERSION, hops, receiver_memo);
+        auto data = parse_memo(text);
+        expect(build_memo(data, 0) == text, "build_memo round trip");
+        expect(data.min_return_units(8) == 1, "minimum return");
+
+        auto packed = make_packed_memo(hops, receiver_memo);
+        auto packed_data = parse_memo(packed);
+        expect(packed_data.destination() == "receiveracct"_n && packed_data.min_return_units(8) == 1, "packed memo fields");
+        expect(packed_data.receiver_memo == receiver_memo, "packed receiver memo");
+    }
+
+    // the hop cursor must point at a step of the path, empty paths are rejected
+    memo_structure empty_path;
+    for (std::string memo : { std::string("1,,0,test1"), std::string("1.1,5,,0,test1"), std::string("1.1,1,cnvtaa BNT,0,test1"),
+                              build_packed_memo(empty_path, 1, "test1"_n) }) {
+        try {
+            parse_memo(memo);
+            expect(false, ("memo without a current step accepted: " + memo).c_str());
+        }
+        catch (const std::runtime_error&) {}
+    }
+
+    expect(parse_decimal_amount("9.223372036854775807", 18) == INT64_MAX, "largest amount");
+    expect(parse_decimal_amount("0.123456789", 4) == 1234, "truncated amount");
+    expect(parse_decimal_amount("9223372036854775807", 0) == INT64_MAX, "largest integer amount");
+    std::pair<const char*, uint8_t> too_large[] = { { "9223372036854775808", 0 }, { "20000000000000000000", 0 }, { "99999999999999999999999", 0 },
+                                                    { "92233720368.54775808", 8 }, { "10", 18 } };
+    for (auto& amount : too_large) {
+        try {
+            parse_decimal_amount(amount.first, amount.second);
+            expect(false, (std::string("amount overflow accepted: ") + amount.first).c_str());
+        }
+        catch (const std::runtime_error&) {}
+    }
+
+    printf(ok ? "ok\n" : "common.hpp check failed\n");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--check") == 0)
+        return check() ? 0 : 1;
+
+    const size_t iterations = 200000;
+    const std::string long_receiver_memo(200, 'x');
+    char name_buffer[64];
+
+    printf("%-40s %10s %10s\n", "", "ns/op", "allocs/op");
+
+    for (size_t hops : { 1, 2, 4, 10 }) {
+        for (const char* version : { MEMO_VERSION, MEMO_VERSION_HOP_CURSOR, MEMO_VERSION_PACKED }) {
+            for (bool long_memo : { false, true }) {
+                const std::string& receiver_memo = long_memo ? long_receiver_memo : std::string();
+                std::string memo = strcmp(version, MEMO_VERSION_PACKED) == 0 ? make_packed_memo(hops, receiver_memo)
+                                                                               : make_memo(version, hops, receiver_memo);
+                auto data = parse_memo(memo);
+                const char* suffix = long_memo ? " +memo" : "";
+
+                snprintf(name_buffer, sizeof(name_buffer), "parse_memo v%s %zu hops%s", version, hops, suffix);
+                report(name_buffer, measure(iterations, [&]() { keep(parse_memo(memo)); }));
+
+                if (hops > 1) {
+                    snprintf(name_buffer, sizeof(name_buffer), "next_hop v%s %zu hops%s", version, hops, suffix);
+                    report(name_buffer, measure(iterations, [&]() { keep(next_hop(memo, data)); }));
+                }
+
+                if (strcmp(version, MEMO_VERSION) == 0) {
+                    snprintf(name_buffer, sizeof(name_buffer), "build_memo %zu hops%s", hops, suffix);
+                    report(name_buffer, measure(iterations, [&]() { keep(build_memo(data, 0)); }));
+
+                    snprintf(name_buffer, sizeof(name_buffer), "build_packed_memo %zu hops%s", hops, suffix);
+                    report(name_buffer, measure(iterations, [&]() { keep(build_packed_memo(data, 1, "receiveracct"_n)); }));
+                }
+            }
+        }
+    }
+
+    std::string_view path = "cnvtconverta BNT cnvtconvertb TKNA cnvtconvertc BNT cnvtconvertd TKNB";
+    report("next_token 4 hop path", measure(iterations, [&]() {
+        string_view rest = path;
+        while (!rest.empty())
+            keep(next_token(rest, ' '));
+    }));
+    std::string single_hop = make_memo(MEMO_VERSION, 1, "");
+    auto single_hop_data = parse_memo(single_hop);
+    report("converter_name / to_symbol_code", measure(iterations, [&]() {
+        keep(single_hop_data.current_hop().converter_name());
+        keep(single_hop_data.current_hop().to_symbol_code());
+    }));
+
+    for (const char* amount : { "1", "0.00000001", "123456.78901234", "9.223372036854775807", "0.12345678901234567890" }) {
+        snprintf(name_buffer, sizeof(name_buffer), "parse_decimal_amount %s", amount);
+        uint8_t precision = strlen(amount) == 20 ? 18 : 8;
+        report(name_buffer, measure(iterations, [&]() { keep(parse_decimal_amount(amount, precision)); }));
+    }
+
+    // balances and amounts in the smallest token unit, 10 decimals
+    int64_t balance = 100000'0000000000, supply = 250000'0000000000, amount = 5'0000000000;
+    auto b = [&]() { return opaque(balance); };
+    report("calculate_purchase_return", measure(iterations, [&]() { keep(calculate_purchase_return(b() + amount, amount, supply, 500)); }));
+    report("calculate_sale_return", measure(iterations, [&]() { keep(calculate_sale_return(b(), amount, supply, 500)); }));
+    report("calculate_cross_reserve_return", measure(iterations, [&]() { keep(calculate_cross_reserve_return(b(), 400, b(), 600, amount)); }));
+    report("calculate_cross_reserve_return equal", measure(iterations, [&]() { keep(calculate_cross_reserve_return(b(), 500, b(), 500, amount)); }));
+    report("calculate_conversion cross with fee", measure(iterations, [&]() {
+        keep(calculate_conversion({ b(), 500, false }, { b(), 500, false }, supply, 3, amount));
+    }));
+    report("calculate_purchase_return 1 unit", measure(iterations, [&]() { keep(calculate_purchase_return(b() + 1, 1, supply, 500)); }));
+    report("calculate_sale_return half supply", measure(iterations, [&]() { keep(calculate_sale_return(b(), supply / 2, supply, 100)); }));
+
+    return 0;
+}
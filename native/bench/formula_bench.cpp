@@ -0,0 +1,235 @@
+/*
+    Compares the fixed-point bancor formula with the previous double implementation.
+
+    formula_bench           prints the cost per call and the accuracy of both implementations
+    formula_bench --check   only verifies the fixed-point accuracy, exits with 1 on failure
+
+    The reference is computed with long double using log1p / expm1 to avoid
+    cancellation near 1.
+*/
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define BANCOR_FORMULA_ASSERT(test, msg) if (!(test)) throw std::runtime_error(msg)
+#include "bancor_formula.hpp"
+
+// the double implementation the fixed-point formula replaced, amounts in token units
+double double_purchase_return(double balance, double deposit_amount, double supply, int64_t ratio) {
+    double R(supply);
+    double C(balance + deposit_amount);
+    double F(ratio / 1000.0);
+    double T(deposit_amount);
+    double ONE(1.0);
+
+    double E = -R * (ONE - pow(ONE + T / C, F));
+    return E;
+}
+
+double double_sale_return(double balance, double sell_amount, double supply, int64_t ratio) {
+    double R(supply - sell_amount);
+    double C(balance);
+    double F(1000.0 / ratio);
+    double E(sell_amount);
+    double ONE(1.0);
+
+    double T = C * (pow(ONE + E/R, F) - ONE);
+    return T;
+}
+
+long double reference_purchase_return(int64_t balance, int64_t deposit_amount, int64_t supply, uint64_t ratio) {
+    long double base = (long double)deposit_amount / balance;
+    return supply * expm1l(log1pl(base) * ratio / 1000.0L);
+}
+
+long double reference_sale_return(int64_t balance, int64_t sell_amount, int64_t supply, uint64_t ratio) {
+    long double base = (long double)sell_amount / (supply - sell_amount);
+    return balance * expm1l(log1pl(base) * 1000.0L / ratio);
+}
+
+long double reference_cross_reserve_return(int64_t from_balance, uint64_t from_ratio, int64_t to_balance, uint64_t to_ratio, int64_t amount) {
+    long double base = (long double)amount / from_balance;
+    return -to_balance * expm1l(-log1pl(base) * from_ratio / to_ratio);
+}
+
+struct formula_case {
+    int64_t  balance;     // includes the deposit for purchases
+    int64_t  amount;
+    int64_t  supply;      // the 'to' balance for cross reserve conversions
+    uint64_t ratio;
+    uint64_t to_ratio;
+    uint8_t  precision;
+};
+
+std::vector<formula_case> generate_cases(size_t count, bool sale) {
+    std::mt19937_64 rng(sale ? 2 : 1);
+    std::uniform_int_distribution<int> digits(4, 15);
+    std::uniform_int_distribution<uint64_t> ratio(100, 1000);
+    std::uniform_real_distribution<double> fraction(-7, -1);
+
+    auto random_amount = [&]() {
+        return int64_t(std::pow(10.0, digits(rng)) * std::uniform_real_distribution<double>(1, 10)(rng));
+    };
+
+    std::vector<formula_case> cases;
+    while (cases.size() < count) {
+        formula_case c;
+        c.balance = random_amount();
+        c.supply = random_amount();
+        c.ratio = ratio(rng);
+        c.to_ratio = ratio(rng);
+        c.precision = 8;
+        // trade sizes between 10^-7 and 10^-1 of the balance (or supply for sales)
+        c.amount = int64_t((sale ? c.supply : c.balance) * std::pow(10.0, fraction(rng)));
+        if (c.amount == 0)
+            continue;
+        if (!sale)
+            c.balance += c.amount;
+        cases.push_back(c);
+    }
+    return cases;
+}
+
+// cross reserve conversions with very different ratios, where the power underflows
+// the ratio of up to 1000 magnifies the error of the logarithm, so the tolerance is 10^-12
+std::vector<formula_case> extreme_cross_cases() {
+    static const uint64_t ratios[][2] = { { 600, 3 }, { 1000, 1 }, { 999, 2 }, { 500, 1 }, { 1000, 7 } };
+    static const int64_t balances[] = { 10000, 123456789, 100000000000000, 1000000000000000 };
+
+    std::vector<formula_case> cases;
+    for (auto& r : ratios)
+        for (auto balance : balances)
+            for (int64_t amount : { balance / 1000, balance, balance * 2 }) {
+                if (amount <= 0 || amount > INT64_MAX - balance)
+                    continue;
+                // the 'to' balance is the from balance, and a small one
+                cases.push_back({ balance + amount, amount, balance, r[0], r[1], 8 });
+                cases.push_back({ balance + amount, amount, 1000, r[0], r[1], 8 });
+            }
+    return cases;
+}
+
+// results are expected to be within one unit or the relative tolerance of the reference, whichever is larger
+struct accuracy {
+    long double tolerance = 1e-15L;
+    long double max_error = 0;      // in token units
+    long double max_relative = 0;
+    size_t      out_of_tolerance = 0;
+
+    void add(long double value, long double reference) {
+        long double error = fabsl(value - floorl(reference));
+        if (error > max_error)
+            max_error = error;
+        if (reference >= 1 && error / reference > max_relative)
+            max_relative = error / reference;
+        if (error > 1 && error > reference * tolerance)
+            ++out_of_tolerance;
+    }
+};
+
+template<typename F>
+double measure(const std::vector<formula_case>& cases, size_t rounds, F f) {
+    volatile int64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        for (auto& c : cases)
+            sink = sink + f(c);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (rounds * cases.size());
+}
+
+double scale(const formula_case& c) {
+    return std::pow(10.0, c.precision);
+}
+
+int main(int argc, char** argv) {
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+    auto purchases = generate_cases(check ? 20000 : 100000, false);
+    auto sales = generate_cases(check ? 20000 : 100000, true);
+
+    accuracy fixed_purchase, fixed_sale, fixed_cross, double_purchase, double_sale;
+    accuracy fixed_extreme{ 1e-12L };
+    for (auto& c : purchases) {
+        auto reference = reference_purchase_return(c.balance, c.amount, c.supply, c.ratio);
+        fixed_purchase.add(calculate_purchase_return(c.balance, c.amount, c.supply, c.ratio), reference);
+        double s = scale(c);
+        double_purchase.add(int64_t(double_purchase_return((c.balance - c.amount) / s, c.amount / s, c.supply / s, c.ratio) * s), reference);
+
+        reference = reference_cross_reserve_return(c.balance - c.amount, c.ratio, c.supply, c.to_ratio, c.amount);
+        fixed_cross.add(calculate_cross_reserve_return(c.balance - c.amount, c.ratio, c.supply, c.to_ratio, c.amount), reference);
+    }
+    size_t cross_failures = 0;
+    for (auto& c : extreme_cross_cases()) {
+        auto reference = reference_cross_reserve_return(c.balance - c.amount, c.ratio, c.supply, c.to_ratio, c.amount);
+        try {
+            fixed_extreme.add(calculate_cross_reserve_return(c.balance - c.amount, c.ratio, c.supply, c.to_ratio, c.amount), reference);
+        }
+        catch (const std::exception& e) {
+            printf("cross reserve return failed for ratios %llu / %llu, amount %lld: %s\n",
+                   (unsigned long long)c.ratio, (unsigned long long)c.to_ratio, (long long)c.amount, e.what());
+            ++cross_failures;
+        }
+    }
+    for (auto& c : sales) {
+        auto reference = reference_sale_return(c.balance, c.amount, c.supply, c.ratio);
+        fixed_sale.add(calculate_sale_return(c.balance, c.amount, c.supply, c.ratio), reference);
+        double s = scale(c);
+        double_sale.add(int64_t(double_sale_return(c.balance / s, c.amount / s, c.supply / s, c.ratio) * s), reference);
+    }
+
+    auto report = [](const char* name, const accuracy& a) {
+        printf("%-16s max error %10.0Lf units   max relative error %.3Le   out of tolerance %zu\n",
+               name, a.max_error, a.max_relative, a.out_of_tolerance);
+    };
+    report("fixed purchase", fixed_purchase);
+    report("fixed sale", fixed_sale);
+    report("fixed cross", fixed_cross);
+    report("fixed extreme", fixed_extreme);
+
+    if (check) {
+        bool ok = fixed_purchase.out_of_tolerance == 0 && fixed_sale.out_of_tolerance == 0 &&
+                  fixed_cross.out_of_tolerance == 0 && fixed_extreme.out_of_tolerance == 0 && cross_failures == 0;
+        printf(ok ? "ok\n" : "fixed-point formula accuracy check failed\n");
+        return ok ? 0 : 1;
+    }
+
+    report("double purchase", double_purchase);
+    report("double sale", double_sale);
+
+    const size_t rounds = 20;
+    // natively the double path runs on the fpu, in the contract pow and the float
+    // conversions are emulated in software and cost considerably more
+    printf("\nns per call (native)\n");
+    printf("fixed purchase   %8.1f\n", measure(purchases, rounds, [](const formula_case& c) {
+        return calculate_purchase_return(c.balance, c.amount, c.supply, c.ratio);
+    }));
+    printf("double purchase  %8.1f\n", measure(purchases, rounds, [](const formula_case& c) {
+        double s = scale(c);
+        return int64_t(double_purchase_return((c.balance - c.amount) / s, c.amount / s, c.supply / s, c.ratio) * s);
+    }));
+    printf("fixed sale       %8.1f\n", measure(sales, rounds, [](const formula_case& c) {
+        return calculate_sale_return(c.balance, c.amount, c.supply, c.ratio);
+    }));
+    printf("double sale      %8.1f\n", measure(sales, rounds, [](const formula_case& c) {
+        double s = scale(c);
+        return int64_t(double_sale_return(c.balance / s, c.amount / s, c.supply / s, c.ratio) * s);
+    }));
+    // a conversion between two reserves, previously a purchase followed by a sale
+    printf("fixed cross      %8.1f\n", measure(purchases, rounds, [](const formula_case& c) {
+        return calculate_cross_reserve_return(c.balance - c.amount, c.ratio, c.supply, c.to_ratio, c.amount);
+    }));
+    printf("double cross     %8.1f\n", measure(purchases, rounds, [](const formula_case& c) {
+        double s = scale(c);
+        double smart_tokens = double_purchase_return((c.balance - c.amount) / s, c.amount / s, c.supply / s, c.ratio);
+        return int64_t(double_sale_return(c.supply / s, smart_tokens, c.supply / s + smart_tokens, c.to_ratio) * s);
+    }));
+    printf("fixed quick      %8.1f\n", measure(purchases, rounds, [](const formula_case& c) {
+        return quick_convert(c.balance - c.amount, c.amount, c.supply);
+    }));
+
+    return 0;
+}
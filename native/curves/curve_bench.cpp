@@ -0,0 +1,182 @@
+/*
+    Compares the return curve kernels with the fixed-point contract formula.
+
+    curve_bench             prints the accuracy and the evaluations per second of each kernel
+    curve_bench --check     only verifies the accuracy of the kernels, exits with 1 on failure
+*/
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define BANCOR_FORMULA_ASSERT(test, msg) if (!(test)) throw std::runtime_error(msg)
+#include "bancor_formula.hpp"
+#include "return_curves.hpp"
+
+// conversions in the form the kernels take them
+// purchases - balance (including the amount), amount, supply, ratio
+// sales - balance, amount, supply, ratio
+// cross reserve - balance, ratio, to_balance, to_ratio, amount
+struct curve_cases {
+    std::vector<int64_t>  balance;
+    std::vector<int64_t>  amount;
+    std::vector<int64_t>  supply;
+    std::vector<int64_t>  to_balance;
+    std::vector<uint64_t> ratio;
+    std::vector<uint64_t> to_ratio;
+
+    size_t size() const { return amount.size(); }
+};
+
+curve_cases generate_cases(size_t count, bool sale) {
+    std::mt19937_64 rng(sale ? 2 : 1);
+    std::uniform_int_distribution<int> digits(4, 15);
+    std::uniform_int_distribution<uint64_t> ratio(100, 1000);
+    std::uniform_real_distribution<double> fraction(-9, -0.5);
+
+    auto random_amount = [&]() {
+        return int64_t(std::pow(10.0, digits(rng)) * std::uniform_real_distribution<double>(1, 10)(rng));
+    };
+
+    curve_cases cases;
+    while (cases.size() < count) {
+        int64_t balance = random_amount();
+        int64_t supply = random_amount();
+        // trade sizes between 10^-9 and 10^-0.5 of the balance (or supply for sales)
+        int64_t amount = int64_t((sale ? supply : balance) * std::pow(10.0, fraction(rng)));
+        if (amount == 0)
+            continue;
+
+        cases.balance.push_back(sale ? balance : balance + amount);
+        cases.amount.push_back(amount);
+        cases.supply.push_back(supply);
+        cases.to_balance.push_back(random_amount());
+        cases.ratio.push_back(ratio(rng));
+        cases.to_ratio.push_back(ratio(rng));
+    }
+    return cases;
+}
+
+// the curves are expected to be within 4 units or 10^-13 of the contract, whichever is larger
+struct accuracy {
+    double max_error = 0;       // in token units
+    double max_relative = 0;
+    size_t out_of_tolerance = 0;
+
+    void add(double value, int64_t contract) {
+        double error = std::fabs(std::floor(value) - double(contract));
+        if (error > max_error)
+            max_error = error;
+        if (contract >= 1 && error / contract > max_relative)
+            max_relative = error / contract;
+        if (!(error <= 4 || error <= contract * 1e-13))
+            ++out_of_tolerance;
+    }
+};
+
+template<typename F>
+double evaluations_per_second(size_t count, size_t rounds, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        f();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return count * rounds / elapsed;
+}
+
+int main(int argc, char** argv) {
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+    // an odd count also covers the partial last block of the AVX2 kernel
+    auto purchases = generate_cases(check ? 20003 : 100003, false);
+    auto sales = generate_cases(check ? 20003 : 100003, true);
+
+    std::vector<int64_t> fixed_purchase(purchases.size()), fixed_sale(sales.size()), fixed_cross(purchases.size());
+    for (size_t i = 0; i < purchases.size(); ++i) {
+        fixed_purchase[i] = calculate_purchase_return(purchases.balance[i], purchases.amount[i], purchases.supply[i], purchases.ratio[i]);
+        fixed_cross[i] = calculate_cross_reserve_return(purchases.balance[i] - purchases.amount[i], purchases.ratio[i],
+                                                        purchases.to_balance[i], purchases.to_ratio[i], purchases.amount[i]);
+    }
+    for (size_t i = 0; i < sales.size(); ++i)
+        fixed_sale[i] = calculate_sale_return(sales.balance[i], sales.amount[i], sales.supply[i], sales.ratio[i]);
+
+    // the cross reserve cases use the balance without the purchase amount
+    std::vector<int64_t> from_balance(purchases.size());
+    for (size_t i = 0; i < purchases.size(); ++i)
+        from_balance[i] = purchases.balance[i] - purchases.amount[i];
+
+    std::vector<curve_kernel> kernels{ CURVE_KERNEL_SCALAR };
+    if (avx2_kernel_supported())
+        kernels.push_back(CURVE_KERNEL_AVX2);
+    else
+        printf("AVX2 kernel not available\n");
+
+    bool ok = true;
+    std::vector<double> returns(std::max(purchases.size(), sales.size()));
+    for (auto kernel : kernels) {
+        const char* name = kernel == CURVE_KERNEL_AVX2 ? "avx2" : "scalar";
+        accuracy purchase, sale, cross;
+
+        purchase_returns(purchases.balance.data(), purchases.amount.data(), purchases.supply.data(), purchases.ratio.data(),
+                         returns.data(), purchases.size(), kernel);
+        for (size_t i = 0; i < purchases.size(); ++i)
+            purchase.add(returns[i], fixed_purchase[i]);
+
+        sale_returns(sales.balance.data(), sales.amount.data(), sales.supply.data(), sales.ratio.data(), returns.data(), sales.size(), kernel);
+        for (size_t i = 0; i < sales.size(); ++i)
+            sale.add(returns[i], fixed_sale[i]);
+
+        cross_reserve_returns(from_balance.data(), purchases.ratio.data(), purchases.to_balance.data(), purchases.to_ratio.data(),
+                              purchases.amount.data(), returns.data(), purchases.size(), kernel);
+        for (size_t i = 0; i < purchases.size(); ++i)
+            cross.add(returns[i], fixed_cross[i]);
+
+        auto report = [&](const char* formula, const accuracy& a) {
+            printf("%-7s %-9s max error %6.0f units   max relative error %.3e   out of tolerance %zu\n",
+                   name, formula, a.max_error, a.max_relative, a.out_of_tolerance);
+            ok = ok && a.out_of_tolerance == 0;
+        };
+        report("purchase", purchase);
+        report("sale", sale);
+        report("cross", cross);
+    }
+
+    if (check) {
+        printf(ok ? "ok\n" : "return curves accuracy check failed\n");
+        return ok ? 0 : 1;
+    }
+
+    const size_t rounds = 20;
+    printf("\nmillion evaluations per second\n");
+    printf("fixed     purchase %8.2f\n", evaluations_per_second(purchases.size(), rounds, [&]() {
+        for (size_t i = 0; i < purchases.size(); ++i)
+            returns[i] = calculate_purchase_return(purchases.balance[i], purchases.amount[i], purchases.supply[i], purchases.ratio[i]);
+    }) / 1e6);
+    printf("fixed     sale     %8.2f\n", evaluations_per_second(sales.size(), rounds, [&]() {
+        for (size_t i = 0; i < sales.size(); ++i)
+            returns[i] = calculate_sale_return(sales.balance[i], sales.amount[i], sales.supply[i], sales.ratio[i]);
+    }) / 1e6);
+    printf("fixed     cross    %8.2f\n", evaluations_per_second(purchases.size(), rounds, [&]() {
+        for (size_t i = 0; i < purchases.size(); ++i)
+            returns[i] = calculate_cross_reserve_return(from_balance[i], purchases.ratio[i], purchases.to_balance[i], purchases.to_ratio[i],
+                                                        purchases.amount[i]);
+    }) / 1e6);
+
+    for (auto kernel : kernels) {
+        const char* name = kernel == CURVE_KERNEL_AVX2 ? "avx2" : "scalar";
+        printf("%-9s purchase %8.2f\n", name, evaluations_per_second(purchases.size(), rounds, [&]() {
+            purchase_returns(purchases.balance.data(), purchases.amount.data(), purchases.supply.data(), purchases.ratio.data(),
+                             returns.data(), purchases.size(), kernel);
+        }) / 1e6);
+        printf("%-9s sale     %8.2f\n", name, evaluations_per_second(sales.size(), rounds, [&]() {
+            sale_returns(sales.balance.data(), sales.amount.data(), sales.supply.data(), sales.ratio.data(), returns.data(), sales.size(), kernel);
+        }) / 1e6);
+        printf("%-9s cross    %8.2f\n", name, evaluations_per_second(purchases.size(), rounds, [&]() {
+            cross_reserve_returns(from_balance.data(), purchases.ratio.data(), purchases.to_balance.data(), purchases.to_ratio.data(),
+                                  purchases.amount.data(), returns.data(), purchases.size(), kernel);
+        }) / 1e6);
+    }
+
+    return 0;
+}
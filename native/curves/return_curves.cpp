@@ -0,0 +1,58 @@
+#include <cmath>
+
+#include "return_curves.hpp"
+
+bool avx2_kernel_supported() {
+#ifdef CURVES_AVX2
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+curve_kernel resolve_curve_kernel(curve_kernel kernel) {
+    if (kernel == CURVE_KERNEL_AUTO)
+        return avx2_kernel_supported() ? CURVE_KERNEL_AVX2 : CURVE_KERNEL_SCALAR;
+    if (kernel == CURVE_KERNEL_AVX2 && !avx2_kernel_supported())
+        return CURVE_KERNEL_SCALAR;
+    return kernel;
+}
+
+// supply * ((1 + deposit / balance) ^ (ratio / 1000) - 1)
+void purchase_returns(const int64_t* balance, const int64_t* deposit_amount, const int64_t* supply, const uint64_t* ratio,
+                      double* returns, size_t count, curve_kernel kernel) {
+#ifdef CURVES_AVX2
+    if (resolve_curve_kernel(kernel) == CURVE_KERNEL_AVX2)
+        return purchase_returns_avx2(balance, deposit_amount, supply, ratio, returns, count);
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        double base = double(deposit_amount[i]) / double(balance[i]);
+        returns[i] = double(supply[i]) * std::expm1(std::log1p(base) * (double(ratio[i]) / 1000));
+    }
+}
+
+// balance * ((1 + sell / (supply - sell)) ^ (1000 / ratio) - 1)
+void sale_returns(const int64_t* balance, const int64_t* sell_amount, const int64_t* supply, const uint64_t* ratio,
+                  double* returns, size_t count, curve_kernel kernel) {
+#ifdef CURVES_AVX2
+    if (resolve_curve_kernel(kernel) == CURVE_KERNEL_AVX2)
+        return sale_returns_avx2(balance, sell_amount, supply, ratio, returns, count);
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        double base = double(sell_amount[i]) / double(supply[i] - sell_amount[i]);
+        returns[i] = double(balance[i]) * std::expm1(std::log1p(base) * (1000 / double(ratio[i])));
+    }
+}
+
+// to_balance * (1 - (from_balance / (from_balance + amount)) ^ (from_ratio / to_ratio))
+void cross_reserve_returns(const int64_t* from_balance, const uint64_t* from_ratio, const int64_t* to_balance, const uint64_t* to_ratio,
+                           const int64_t* amount, double* returns, size_t count, curve_kernel kernel) {
+#ifdef CURVES_AVX2
+    if (resolve_curve_kernel(kernel) == CURVE_KERNEL_AVX2)
+        return cross_reserve_returns_avx2(from_balance, from_ratio, to_balance, to_ratio, amount, returns, count);
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        double base = double(amount[i]) / double(from_balance[i]);
+        returns[i] = -double(to_balance[i]) * std::expm1(-std::log1p(base) * (double(from_ratio[i]) / double(to_ratio[i])));
+    }
+}
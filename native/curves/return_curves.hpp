@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Return Curves
+
+    Evaluates the bancor purchase, sale and cross reserve returns for arrays of conversions at once,
+    e.g. to plot the slippage curve of a converter at thousands of amounts.
+
+    The inputs are the ones of the matching functions in Common/bancor_formula.hpp and follow the same
+    rules (a purchase balance is expected to include the deposit amount), every array holds count elements and the
+    results are returned in the smallest token unit, not rounded.
+    The curves are calculated in double precision with log1p / expm1, so a result is within a few
+    units or 10^-13 of the fixed-point contract result, which remains the one used for conversions.
+    Results for inputs the contract formula rejects are undefined.
+
+    The AVX2 kernel evaluates 4 conversions per instruction and is used when the cpu supports it,
+    the scalar kernel uses the standard library math.
+*/
+
+enum curve_kernel {
+    CURVE_KERNEL_AUTO,      // AVX2 when available, otherwise scalar
+    CURVE_KERNEL_SCALAR,
+    CURVE_KERNEL_AVX2
+};
+
+// returns true if the AVX2 kernel is built and supported by the cpu
+bool avx2_kernel_supported();
+
+// the kernel CURVE_KERNEL_AUTO resolves to
+curve_kernel resolve_curve_kernel(curve_kernel kernel);
+
+void purchase_returns(const int64_t* balance, const int64_t* deposit_amount, const int64_t* supply, const uint64_t* ratio,
+                      double* returns, size_t count, curve_kernel kernel = CURVE_KERNEL_AUTO);
+
+void sale_returns(const int64_t* balance, const int64_t* sell_amount, const int64_t* supply, const uint64_t* ratio,
+                  double* returns, size_t count, curve_kernel kernel = CURVE_KERNEL_AUTO);
+
+void cross_reserve_returns(const int64_t* from_balance, const uint64_t* from_ratio, const int64_t* to_balance, const uint64_t* to_ratio,
+                           const int64_t* amount, double* returns, size_t count, curve_kernel kernel = CURVE_KERNEL_AUTO);
+
+#ifdef CURVES_AVX2
+// the AVX2 kernel, the count is any number of elements
+void purchase_returns_avx2(const int64_t* balance, const int64_t* deposit_amount, const int64_t* supply, const uint64_t* ratio,
+                           double* returns, size_t count);
+void sale_returns_avx2(const int64_t* balance, const int64_t* sell_amount, const int64_t* supply, const uint64_t* ratio,
+                       double* returns, size_t count);
+void cross_reserve_returns_avx2(const int64_t* from_balance, const uint64_t* from_ratio, const int64_t* to_balance, const uint64_t* to_ratio,
+                                const int64_t* amount, double* returns, size_t count);
+#endif
@@ -0,0 +1,177 @@
+/*
+    AVX2 kernel of the return curves, built with -mavx2 -mfma and only called when the cpu supports them.
+
+    log1p and expm1 are evaluated 4 lanes at a time with the usual reductions -
+    log1p splits 1 + x into 2 ^ k * m with m in [sqrt(2) / 2, sqrt(2)) and uses the fdlibm series
+    for log(m), plus a correction for the rounding of 1 + x.
+    expm1 splits x into n * ln(2) + r with |r| <= ln(2) / 2 and uses the taylor series of expm1(r),
+    which keeps full precision for small arguments - the common case for small conversions.
+*/
+#include <immintrin.h>
+
+#include "return_curves.hpp"
+
+namespace {
+
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+#define INV_LN2 1.44269504088896338700e+00
+
+// converts non-negative 64 bit integers to double, AVX2 has no such instruction
+inline __m256d to_double(__m256i x) {
+    const __m256d two_84_52 = _mm256_set1_pd(19342813118337666422669312.0);  // 2 ^ 84 + 2 ^ 52
+    __m256i hi = _mm256_or_si256(_mm256_srli_epi64(x, 32), _mm256_castpd_si256(_mm256_set1_pd(19342813113834066795298816.0)));  // 2 ^ 84
+    __m256i lo = _mm256_blend_epi32(x, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)), 0xaa);  // 2 ^ 52
+    return _mm256_add_pd(_mm256_sub_pd(_mm256_castsi256_pd(hi), two_84_52), _mm256_castsi256_pd(lo));
+}
+
+inline __m256i load(const int64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline __m256i load(const uint64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// log(1 + x), x >= 0
+inline __m256d log1p(__m256d x) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d u = _mm256_add_pd(one, x);
+    // c is the part of x lost when rounding 1 + x, divided by u - log(1 + x) = log(u) + c
+    __m256d c = _mm256_div_pd(_mm256_sub_pd(x, _mm256_sub_pd(u, one)), u);
+
+    // u = 2 ^ k * m, m in [1, 2)
+    __m256i bits = _mm256_castpd_si256(u);
+    __m256i exponent = _mm256_srli_epi64(bits, 52);
+    __m256d k = _mm256_sub_pd(to_double(exponent), _mm256_set1_pd(1023.0));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffffll)),
+                                                    _mm256_castpd_si256(one)));
+
+    // moves m into [sqrt(2) / 2, sqrt(2))
+    __m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(1.41421356237309504880), _CMP_GE_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+    k = _mm256_add_pd(k, _mm256_and_pd(large, one));
+
+    // log(m) = f - (f^2 / 2 - s * (f^2 / 2 + R)) where f = m - 1, s = f / (2 + f)
+    __m256d f = _mm256_sub_pd(m, one);
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d w = _mm256_mul_pd(z, z);
+    __m256d t1 = _mm256_fmadd_pd(w, _mm256_set1_pd(1.531383769920937332e-01), _mm256_set1_pd(2.222219843214978396e-01));
+    t1 = _mm256_fmadd_pd(w, t1, _mm256_set1_pd(3.999999999940941908e-01));
+    t1 = _mm256_mul_pd(w, t1);
+    __m256d t2 = _mm256_fmadd_pd(w, _mm256_set1_pd(1.479819860511658591e-01), _mm256_set1_pd(1.818357216161805012e-01));
+    t2 = _mm256_fmadd_pd(w, t2, _mm256_set1_pd(2.857142874366239149e-01));
+    t2 = _mm256_fmadd_pd(w, t2, _mm256_set1_pd(6.666666666666735130e-01));
+    t2 = _mm256_mul_pd(z, t2);
+    __m256d r = _mm256_add_pd(t1, t2);
+    __m256d hfsq = _mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_mul_pd(f, f));
+
+    __m256d lo = _mm256_fmadd_pd(s, _mm256_add_pd(hfsq, r), _mm256_fmadd_pd(k, _mm256_set1_pd(LN2_LO), c));
+    __m256d res = _mm256_sub_pd(f, _mm256_sub_pd(hfsq, lo));
+    return _mm256_fmadd_pd(k, _mm256_set1_pd(LN2_HI), res);
+}
+
+// e ^ x - 1, |x| < 700
+inline __m256d expm1(__m256d x) {
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(INV_LN2)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+
+    // expm1(r) = r + r^2 / 2! + ... + r^13 / 13!
+    static const double coefficients[] = {
+        1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0,
+        1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 1.0 / 2.0, 1.0
+    };
+    __m256d p = _mm256_set1_pd(coefficients[0]);
+    for (size_t i = 1; i < sizeof(coefficients) / sizeof(coefficients[0]); ++i)
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(coefficients[i]));
+    p = _mm256_mul_pd(p, r);
+
+    // e ^ x - 1 = 2 ^ n * expm1(r) + 2 ^ n - 1, exact for n = 0
+    __m256i biased = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023));
+    __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52));
+    return _mm256_fmadd_pd(scale, p, _mm256_sub_pd(scale, _mm256_set1_pd(1.0)));
+}
+
+// evaluates the full blocks of 4 and then the remaining elements, padded with copies of the first one
+template<typename Block, typename Tail>
+void evaluate(size_t count, double* returns, Block block, Tail tail) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm256_storeu_pd(returns + i, block(i));
+
+    if (i < count) {
+        double res[4];
+        _mm256_storeu_pd(res, tail(i, count - i));
+        for (size_t j = 0; i + j < count; ++j)
+            returns[i + j] = res[j];
+    }
+}
+
+// copies the last elements of an array into a block of 4
+template<typename T>
+struct padded {
+    T values[4];
+
+    padded(const T* p, size_t offset, size_t count) {
+        for (size_t j = 0; j < 4; ++j)
+            values[j] = p[offset + (j < count ? j : 0)];
+    }
+};
+
+inline __m256d purchase_block(const int64_t* balance, const int64_t* deposit_amount, const int64_t* supply, const uint64_t* ratio) {
+    __m256d base = _mm256_div_pd(to_double(load(deposit_amount)), to_double(load(balance)));
+    __m256d exponent = _mm256_div_pd(to_double(load(ratio)), _mm256_set1_pd(1000.0));
+    return _mm256_mul_pd(to_double(load(supply)), expm1(_mm256_mul_pd(log1p(base), exponent)));
+}
+
+inline __m256d sale_block(const int64_t* balance, const int64_t* sell_amount, const int64_t* supply, const uint64_t* ratio) {
+    __m256i sell = load(sell_amount);
+    __m256d base = _mm256_div_pd(to_double(sell), to_double(_mm256_sub_epi64(load(supply), sell)));
+    __m256d exponent = _mm256_div_pd(_mm256_set1_pd(1000.0), to_double(load(ratio)));
+    return _mm256_mul_pd(to_double(load(balance)), expm1(_mm256_mul_pd(log1p(base), exponent)));
+}
+
+inline __m256d cross_reserve_block(const int64_t* from_balance, const uint64_t* from_ratio, const int64_t* to_balance, const uint64_t* to_ratio,
+                                   const int64_t* amount) {
+    __m256d base = _mm256_div_pd(to_double(load(amount)), to_double(load(from_balance)));
+    __m256d exponent = _mm256_div_pd(to_double(load(from_ratio)), to_double(load(to_ratio)));
+    __m256d neg_to_balance = _mm256_sub_pd(_mm256_setzero_pd(), to_double(load(to_balance)));
+    return _mm256_mul_pd(neg_to_balance, expm1(_mm256_fnmadd_pd(log1p(base), exponent, _mm256_setzero_pd())));
+}
+
+}
+
+void purchase_returns_avx2(const int64_t* balance, const int64_t* deposit_amount, const int64_t* supply, const uint64_t* ratio,
+                           double* returns, size_t count) {
+    evaluate(count, returns,
+        [&](size_t i) { return purchase_block(balance + i, deposit_amount + i, supply + i, ratio + i); },
+        [&](size_t i, size_t n) {
+            padded<int64_t> b(balance, i, n), d(deposit_amount, i, n), s(supply, i, n);
+            padded<uint64_t> r(ratio, i, n);
+            return purchase_block(b.values, d.values, s.values, r.values);
+        });
+}
+
+void sale_returns_avx2(const int64_t* balance, const int64_t* sell_amount, const int64_t* supply, const uint64_t* ratio,
+                       double* returns, size_t count) {
+    evaluate(count, returns,
+        [&](size_t i) { return sale_block(balance + i, sell_amount + i, supply + i, ratio + i); },
+        [&](size_t i, size_t n) {
+            padded<int64_t> b(balance, i, n), a(sell_amount, i, n), s(supply, i, n);
+            padded<uint64_t> r(ratio, i, n);
+            return sale_block(b.values, a.values, s.values, r.values);
+        });
+}
+
+void cross_reserve_returns_avx2(const int64_t* from_balance, const uint64_t* from_ratio, const int64_t* to_balance, const uint64_t* to_ratio,
+                                const int64_t* amount, double* returns, size_t count) {
+    evaluate(count, returns,
+        [&](size_t i) { return cross_reserve_block(from_balance + i, from_ratio + i, to_balance + i, to_ratio + i, amount + i); },
+        [&](size_t i, size_t n) {
+            padded<int64_t> fb(from_balance, i, n), tb(to_balance, i, n), a(amount, i, n);
+            padded<uint64_t> fr(from_ratio, i, n), tr(to_ratio, i, n);
+            return cross_reserve_block(fb.values, fr.values, tb.values, tr.values, a.values);
+        });
+}
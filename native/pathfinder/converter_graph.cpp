@@ -0,0 +1,279 @@
+#include "converter_graph.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// a minimal json document model, only what the table snapshots need
+struct json_value {
+    enum kind_t { null_value, bool_value, number_value, string_value, array_value, object_value };
+
+    kind_t                                              kind = null_value;
+    bool                                                boolean = false;
+    std::string                                         text;       // strings and numbers, as written
+    std::vector<json_value>                             items;
+    std::vector<std::pair<std::string, json_value>>     members;
+
+    const json_value& operator[](const std::string& key) const {
+        for (auto& member : members)
+            if (member.first == key)
+                return member.second;
+        throw std::runtime_error("missing json member '" + key + "'");
+    }
+
+    const std::string& as_string() const {
+        if (kind != string_value)
+            throw std::runtime_error("expected a json string");
+        return text;
+    }
+
+    uint64_t as_uint() const {
+        if (kind == bool_value)
+            return boolean;
+        if (kind != number_value && kind != string_value)
+            throw std::runtime_error("expected a json number");
+        return std::stoull(text);
+    }
+
+    bool as_bool() const { return as_uint() != 0; }
+};
+
+class json_parser {
+    public:
+        explicit json_parser(const std::string& text) : str(text) {}
+
+        json_value parse() {
+            json_value value = parse_value();
+            skip_whitespace();
+            if (pos != str.size())
+                fail("unexpected trailing characters");
+            return value;
+        }
+
+    private:
+        const std::string& str;
+        size_t pos = 0;
+
+        [[noreturn]] void fail(const char* msg) {
+            throw std::runtime_error(std::string("invalid json at offset ") + std::to_string(pos) + ": " + msg);
+        }
+
+        void skip_whitespace() {
+            while (pos < str.size() && isspace(static_cast<unsigned char>(str[pos])))
+                ++pos;
+        }
+
+        void expect(char c) {
+            skip_whitespace();
+            if (pos >= str.size() || str[pos] != c)
+                fail("unexpected character");
+            ++pos;
+        }
+
+        bool consume(char c) {
+            skip_whitespace();
+            if (pos < str.size() && str[pos] == c) {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+
+        std::string parse_string() {
+            expect('"');
+            std::string res;
+            while (pos < str.size() && str[pos] != '"') {
+                char c = str[pos++];
+                if (c == '\\') {
+                    if (pos >= str.size())
+                        fail("unterminated string");
+                    c = str[pos++];
+                    switch (c) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'u': pos += 4; c = '?'; break; // table values are ascii
+                    }
+                }
+                res.push_back(c);
+            }
+            expect('"');
+            return res;
+        }
+
+        json_value parse_value() {
+            skip_whitespace();
+            if (pos >= str.size())
+                fail("unexpected end of input");
+
+            json_value value;
+            char c = str[pos];
+            if (c == '{') {
+                value.kind = json_value::object_value;
+                ++pos;
+                if (!consume('}')) {
+                    do {
+                        std::string key = parse_string();
+                        expect(':');
+                        value.members.emplace_back(std::move(key), parse_value());
+                    } while (consume(','));
+                    expect('}');
+                }
+            }
+            else if (c == '[') {
+                value.kind = json_value::array_value;
+                ++pos;
+                if (!consume(']')) {
+                    do {
+                        value.items.push_back(parse_value());
+                    } while (consume(','));
+                    expect(']');
+                }
+            }
+            else if (c == '"') {
+                value.kind = json_value::string_value;
+                value.text = parse_string();
+            }
+            else if (str.compare(pos, 4, "true") == 0 || str.compare(pos, 5, "false") == 0) {
+                value.kind = json_value::bool_value;
+                value.boolean = str[pos] == 't';
+                pos += value.boolean ? 4 : 5;
+            }
+            else if (str.compare(pos, 4, "null") == 0) {
+                pos += 4;
+            }
+            else {
+                value.kind = json_value::number_value;
+                size_t start = pos;
+                while (pos < str.size() && (isdigit(static_cast<unsigned char>(str[pos])) || str[pos] == '-' || str[pos] == '+' ||
+                                            str[pos] == '.' || str[pos] == 'e' || str[pos] == 'E'))
+                    ++pos;
+                if (start == pos)
+                    fail("unexpected character");
+                value.text = str.substr(start, pos - start);
+            }
+            return value;
+        }
+};
+
+// an asset as printed by the chain, e.g. "1.0000 EOS"
+struct parsed_asset {
+    int64_t     amount;
+    uint8_t     precision;
+    std::string symbol;
+};
+
+parsed_asset parse_asset(const std::string& text) {
+    size_t space = text.find(' ');
+    if (space == std::string::npos)
+        throw std::runtime_error("invalid asset '" + text + "'");
+
+    std::string number = text.substr(0, space);
+    parsed_asset res;
+    res.symbol = text.substr(space + 1);
+
+    size_t dot = number.find('.');
+    res.precision = dot == std::string::npos ? 0 : uint8_t(number.size() - dot - 1);
+    if (dot != std::string::npos)
+        number.erase(dot, 1);
+    res.amount = std::stoll(number);
+    return res;
+}
+
+}
+
+converter_graph converter_graph::from_file(const std::string& path) {
+    std::ifstream file(path);
+    if (!file)
+        throw std::runtime_error("cannot open " + path);
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return from_json(buffer.str());
+}
+
+converter_graph converter_graph::from_json(const std::string& json) {
+    json_value document = json_parser(json).parse();
+
+    converter_graph graph;
+    for (auto& entry : document["converters"].items) {
+        auto& settings = entry["settings"];
+        if (!settings["enabled"].as_bool())
+            continue;
+
+        converter_info converter;
+        converter.account = entry["account"].as_string();
+        converter.fee = settings["fee"].as_uint();
+
+        auto smart_currency = parse_asset(settings["smart_currency"].as_string());
+        auto smart_supply = parse_asset(settings["smart_supply"].as_string());
+        converter.smart_supply = smart_supply.amount + smart_currency.amount;
+
+        converter_token smart;
+        smart.token = graph.add_token(settings["smart_contract"].as_string(), smart_currency.symbol, smart_currency.precision);
+        smart.balance = 0;
+        smart.ratio = 0;
+        smart.p_enabled = settings["smart_enabled"].as_bool();
+        converter.tokens.push_back(smart);
+
+        for (auto& row : entry["reserves"].items) {
+            auto currency = parse_asset(row["currency"].as_string());
+            auto balance = parse_asset(row["balance"].as_string());
+
+            converter_token reserve;
+            reserve.token = graph.add_token(row["contract"].as_string(), currency.symbol, currency.precision);
+            reserve.balance = balance.amount + currency.amount;
+            reserve.ratio = row["ratio"].as_uint();
+            reserve.p_enabled = row["p_enabled"].as_bool();
+            converter.tokens.push_back(reserve);
+        }
+
+        if (converter.tokens.size() > 255)
+            throw std::runtime_error("too many reserves in " + converter.account);
+        graph.converters.push_back(std::move(converter));
+    }
+
+    graph.build_edges();
+    return graph;
+}
+
+uint32_t converter_graph::add_token(const std::string& contract, const std::string& symbol, uint8_t precision) {
+    auto key = contract + ':' + symbol;
+    auto existing = token_ids.find(key);
+    if (existing != token_ids.end())
+        return existing->second;
+
+    uint32_t id = tokens.size();
+    tokens.push_back({ contract, symbol, precision });
+    token_ids.emplace(key, id);
+    return id;
+}
+
+uint32_t converter_graph::find_token(const std::string& contract, const std::string& symbol) const {
+    auto existing = token_ids.find(contract + ':' + symbol);
+    return existing == token_ids.end() ? NO_TOKEN : existing->second;
+}
+
+// every ordered pair of converter tokens is an edge, unless purchases of the 'to' token are disabled
+void converter_graph::build_edges() {
+    std::vector<std::vector<graph_edge>> by_token(tokens.size());
+    for (uint32_t c = 0; c < converters.size(); ++c) {
+        auto& converter_tokens = converters[c].tokens;
+        for (uint8_t from = 0; from < converter_tokens.size(); ++from)
+            for (uint8_t to = 0; to < converter_tokens.size(); ++to)
+                if (from != to && converter_tokens[to].p_enabled)
+                    by_token[converter_tokens[from].token].push_back({ c, from, to, converter_tokens[to].token });
+    }
+
+    edges.clear();
+    edge_offsets.assign(1, 0);
+    for (auto& token_edges : by_token) {
+        edges.insert(edges.end(), token_edges.begin(), token_edges.end());
+        edge_offsets.push_back(edges.size());
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/*
+    Converter Graph
+
+    A compact snapshot of the converters in a network - every token is a node and every
+    possible conversion step is an edge, grouped by the 'from' token.
+
+    The snapshot is loaded from a json document holding the tables of each converter,
+    as returned by get_table_rows -
+
+    {
+        "converters": [
+            {
+                "account": "cnvtaa",
+                "settings": { <the converter settings row> },
+                "reserves": [ <the converter reserves rows> ]
+            },
+            ...
+        ]
+    }
+
+    Balances and the smart token supply are the ones tracked by the converter,
+    virtual balances are added when the snapshot is loaded.
+*/
+
+#define NO_TOKEN uint32_t(-1)
+#define NO_CONVERTER uint32_t(-1)
+
+struct token_info {
+    std::string contract;
+    std::string symbol;
+    uint8_t     precision;
+};
+
+// a reserve of a converter, or its smart token, index 0 is always the smart token
+struct converter_token {
+    uint32_t token;
+    int64_t  balance;   // including the virtual balance, unused for the smart token
+    uint64_t ratio;
+    bool     p_enabled; // purchases enabled
+};
+
+struct converter_info {
+    std::string                  account;
+    uint64_t                     fee;
+    int64_t                      smart_supply;  // including the virtual amount
+    std::vector<converter_token> tokens;
+};
+
+// a single conversion step
+struct graph_edge {
+    uint32_t converter;
+    uint8_t  from;          // index in the converter tokens
+    uint8_t  to;
+    uint32_t to_token;
+};
+
+class converter_graph {
+    public:
+        std::vector<token_info>     tokens;
+        std::vector<converter_info> converters;
+        std::vector<graph_edge>     edges;          // grouped by 'from' token
+        std::vector<uint32_t>       edge_offsets;   // edges of token i are [edge_offsets[i], edge_offsets[i + 1])
+
+        // throws std::runtime_error on invalid input
+        static converter_graph from_json(const std::string& json);
+        static converter_graph from_file(const std::string& path);
+
+        // returns NO_TOKEN if the token isn't in the graph
+        uint32_t find_token(const std::string& contract, const std::string& symbol) const;
+
+        size_t edge_count(uint32_t token) const { return edge_offsets[token + 1] - edge_offsets[token]; }
+        const graph_edge* edges_from(uint32_t token) const { return edges.data() + edge_offsets[token]; }
+
+    private:
+        std::unordered_map<std::string, uint32_t> token_ids;
+
+        uint32_t add_token(const std::string& contract, const std::string& symbol, uint8_t precision);
+        void build_edges();
+};
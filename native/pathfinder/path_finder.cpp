@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#define BANCOR_FORMULA_ASSERT(test, msg) if (!(test)) throw std::runtime_error(msg)
+#include "conversion.hpp"
+#include "path_finder.hpp"
+
+namespace {
+
+conversion_token to_conversion_token(const converter_token& token, uint8_t index) {
+    return { token.balance, token.ratio, index == 0 };
+}
+
+// returns the result of a step or a zero return if the formula rejects its input
+conversion_result convert(const converter_info& converter, uint8_t from, uint8_t to, int64_t amount) {
+    try {
+        return calculate_conversion(to_conversion_token(converter.tokens[from], from), to_conversion_token(converter.tokens[to], to),
+                                    converter.smart_supply, converter.fee, amount);
+    }
+    catch (const std::runtime_error&) {
+        return conversion_result{};
+    }
+}
+
+// the edge that reached a token in a round and the token it was taken from
+struct step_parent {
+    uint32_t edge;
+    uint32_t from_token;
+};
+
+}
+
+path_result path_finder::find_best_path(uint32_t from, uint32_t to, int64_t amount) const {
+    path_result res;
+    if (from >= graph.tokens.size() || to >= graph.tokens.size() || from == to || amount <= 0)
+        return res;
+
+    size_t token_count = graph.tokens.size();
+    std::vector<int64_t> current(token_count, 0), next(token_count, 0);
+    std::vector<uint32_t> reached{ from }, next_reached;
+    std::vector<std::vector<step_parent>> parents(max_hops, std::vector<step_parent>(token_count));
+    current[from] = amount;
+
+    // the best estimated arrival at the target in every round
+    std::vector<int64_t> candidates(max_hops, 0);
+    std::vector<step_parent> candidate_parents(max_hops);
+
+    for (unsigned round = 0; round < max_hops && !reached.empty(); ++round) {
+        next_reached.clear();
+        for (uint32_t token : reached) {
+            // a converter can't send the return of a step to itself, consecutive steps use different converters
+            uint32_t previous_converter = round > 0 ? graph.edges[parents[round - 1][token].edge].converter : NO_CONVERTER;
+            const graph_edge* edges = graph.edges_from(token);
+            for (size_t e = 0, count = graph.edge_count(token); e < count; ++e) {
+                auto& edge = edges[e];
+                if (edge.to_token == from || edge.converter == previous_converter)
+                    continue;
+
+                // the smart token can only be purchased in the last step
+                bool purchase = edge.to == 0;
+                if (purchase && edge.to_token != to)
+                    continue;
+
+                int64_t to_amount = convert(graph.converters[edge.converter], edge.from, edge.to, current[token]).to_amount;
+                if (to_amount <= 0)
+                    continue;
+
+                step_parent parent{ uint32_t(edges - graph.edges.data() + e), token };
+                if (edge.to_token == to) {
+                    if (to_amount > candidates[round]) {
+                        candidates[round] = to_amount;
+                        candidate_parents[round] = parent;
+                    }
+                    continue;
+                }
+
+                if (to_amount > next[edge.to_token]) {
+                    if (next[edge.to_token] == 0)
+                        next_reached.push_back(edge.to_token);
+                    next[edge.to_token] = to_amount;
+                    parents[round][edge.to_token] = parent;
+                }
+            }
+        }
+
+        for (uint32_t token : reached)
+            current[token] = 0;
+        for (uint32_t token : next_reached) {
+            current[token] = next[token];
+            next[token] = 0;
+        }
+        std::swap(reached, next_reached);
+    }
+
+    // the estimates don't account for a converter used more than once in a path,
+    // so the candidates are ranked by their return calculated step by step
+    for (unsigned candidate_round = 0; candidate_round < max_hops; ++candidate_round) {
+        if (candidates[candidate_round] == 0)
+            continue;
+
+        // walk the parents back from the target, one round at a time
+        path_result candidate;
+        candidate.steps.resize(candidate_round + 1);
+        step_parent parent = candidate_parents[candidate_round];
+        for (int round = candidate_round; round >= 0; --round) {
+            auto& edge = graph.edges[parent.edge];
+            candidate.steps[round] = { edge.converter, edge.to_token, 0, 0 };
+            if (round > 0)
+                parent = parents[round - 1][parent.from_token];
+        }
+
+        if (calculate_path(from, amount, candidate) && candidate.amount > res.amount)
+            res = std::move(candidate);
+    }
+    return res;
+}
+
+bool path_finder::calculate_path(uint32_t from, int64_t amount, path_result& path) const {
+    // copies of the converters the path already used
+    std::vector<converter_info> used;
+    std::vector<uint32_t> used_ids;
+
+    uint32_t token = from;
+    for (auto& step : path.steps) {
+        size_t index = std::find(used_ids.begin(), used_ids.end(), step.converter) - used_ids.begin();
+        if (index == used_ids.size()) {
+            used_ids.push_back(step.converter);
+            used.push_back(graph.converters[step.converter]);
+        }
+        auto& converter = used[index];
+
+        uint8_t from_index = 0, to_index = 0;
+        bool from_found = false, to_found = false;
+        for (uint8_t i = 0; i < converter.tokens.size(); ++i) {
+            if (converter.tokens[i].token == token && !from_found) {
+                from_index = i;
+                from_found = true;
+            }
+            if (converter.tokens[i].token == step.to_token && !to_found) {
+                to_index = i;
+                to_found = true;
+            }
+        }
+        if (!from_found || !to_found || from_index == to_index)
+            return false;
+
+        auto result = convert(converter, from_index, to_index, amount);
+        if (result.to_amount <= 0)
+            return false;
+
+        if (from_index != 0)
+            converter.tokens[from_index].balance += amount;
+        if (to_index != 0)
+            converter.tokens[to_index].balance = result.to_balance;
+        converter.smart_supply = result.smart_supply;
+
+        step.to_amount = result.to_amount;
+        step.fee_amount = result.fee_amount;
+        amount = result.to_amount;
+        token = step.to_token;
+    }
+
+    path.found = true;
+    path.amount = amount;
+    return true;
+}
+
+std::vector<path_result> path_finder::find_best_paths(const std::vector<path_query>& queries, unsigned threads) const {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<path_result> results(queries.size());
+    std::atomic<size_t> next_query{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next_query++; i < queries.size(); i = next_query++)
+            results[i] = find_best_path(queries[i].from, queries[i].to, queries[i].amount);
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers)
+        w.join();
+
+    return results;
+}
+
+std::string path_finder::build_memo(const path_result& path, int64_t min_return, const std::string& destination) const {
+    std::string memo = "1,";
+    for (size_t i = 0; i < path.steps.size(); ++i) {
+        if (i > 0)
+            memo += ' ';
+        memo += graph.converters[path.steps[i].converter].account;
+        memo += ' ';
+        memo += graph.tokens[path.steps[i].to_token].symbol;
+    }
+
+    uint8_t precision = path.steps.empty() ? 0 : graph.tokens[path.steps.back().to_token].precision;
+    memo += ',' + format_amount(min_return, precision) + ',' + destination;
+    return memo;
+}
+
+std::string format_amount(int64_t amount, uint8_t precision) {
+    std::string digits = std::to_string(amount < 0 ? -amount : amount);
+    if (digits.size() <= precision)
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    if (precision > 0)
+        digits.insert(digits.size() - precision, 1, '.');
+    return amount < 0 ? '-' + digits : digits;
+}
+
+int64_t parse_amount(const std::string& text, uint8_t precision) {
+    size_t dot = text.find('.');
+    std::string integer = text.substr(0, dot);
+    std::string fraction = dot == std::string::npos ? "" : text.substr(dot + 1);
+    fraction.resize(precision, '0');
+
+    std::string digits = integer + fraction;
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos || digits.size() > 18)
+        throw std::runtime_error("invalid amount '" + text + "'");
+    return std::stoll(digits);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "converter_graph.hpp"
+
+/*
+    Path Finder
+
+    Searches for the conversion path with the highest return between two tokens in a converter graph.
+
+    Every round relaxes all the edges of the tokens reached in the previous round and keeps
+    the best amount that reaches each token, calculated from the converters' current state.
+    This is an estimate when a path uses a converter more than once, since the earlier step
+    changes that converter's balances, so the best arrival at the target in every round is
+    calculated again step by step and the candidates are ranked by that return.
+    The result is the best of these candidates, not necessarily the best path in the graph.
+    Consecutive steps never use the same converter, the contracts reject such paths.
+
+    The conversion steps are calculated with Common/conversion.hpp, the code the contracts use.
+    Queries are independent and find_best_paths spreads them over threads.
+*/
+
+#define DEFAULT_MAX_HOPS 4
+
+struct path_step {
+    uint32_t converter;
+    uint32_t to_token;
+    int64_t  to_amount;
+    int64_t  fee_amount;
+};
+
+struct path_result {
+    bool                   found = false;
+    int64_t                amount = 0;  // return of the last step
+    std::vector<path_step> steps;
+};
+
+struct path_query {
+    uint32_t from;
+    uint32_t to;
+    int64_t  amount;
+};
+
+class path_finder {
+    public:
+        explicit path_finder(const converter_graph& graph, unsigned max_hops = DEFAULT_MAX_HOPS) : graph(graph), max_hops(max_hops) {}
+
+        path_result find_best_path(uint32_t from, uint32_t to, int64_t amount) const;
+
+        // answers the queries on the given number of threads, 0 uses all the hardware threads
+        std::vector<path_result> find_best_paths(const std::vector<path_query>& queries, unsigned threads = 0) const;
+
+        // builds a version 1 conversion memo for the path
+        std::string build_memo(const path_result& path, int64_t min_return, const std::string& destination) const;
+
+        // calculates the path step by step, returns false if a step fails
+        bool calculate_path(uint32_t from, int64_t amount, path_result& path) const;
+
+    private:
+        const converter_graph& graph;
+        unsigned               max_hops;
+};
+
+// formats an amount in the smallest token unit as a decimal number, e.g. 15000 with precision 4 is 1.5000
+std::string format_amount(int64_t amount, uint8_t precision);
+
+// parses a decimal number into an amount in the smallest token unit, extra fraction digits are truncated
+// throws std::runtime_error on invalid input
+int64_t parse_amount(const std::string& text, uint8_t precision);
@@ -0,0 +1,135 @@
+/*
+    path_finder_test <snapshot>
+
+    Checks the path finder against an exhaustive search over the test snapshot,
+    exits with 1 on failure.
+*/
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "path_finder.hpp"
+
+static int failures = 0;
+
+#define CHECK(test, msg) if (!(test)) { printf("FAILED: %s (line %d)\n", msg, __LINE__); ++failures; }
+
+// the best return of all the paths up to max_hops steps, calculated step by step
+static void exhaustive_search(const converter_graph& graph, const path_finder& finder, uint32_t from, uint32_t to, int64_t amount,
+                              unsigned max_hops, path_result& path, int64_t& best) {
+    uint32_t token = path.steps.empty() ? from : path.steps.back().to_token;
+    if (token == to) {
+        path_result calculated = path;
+        if (finder.calculate_path(from, amount, calculated) && calculated.amount > best)
+            best = calculated.amount;
+        return;
+    }
+    if (path.steps.size() == max_hops)
+        return;
+
+    for (size_t e = 0; e < graph.edge_count(token); ++e) {
+        auto& edge = graph.edges_from(token)[e];
+        if (edge.to_token == from || (edge.to == 0 && edge.to_token != to))
+            continue;
+        if (!path.steps.empty() && path.steps.back().converter == edge.converter)
+            continue;
+
+        path.steps.push_back({ edge.converter, edge.to_token, 0, 0 });
+        exhaustive_search(graph, finder, from, to, amount, max_hops, path, best);
+        path.steps.pop_back();
+    }
+}
+
+static uint32_t token(const converter_graph& graph, const char* contract, const char* symbol) {
+    uint32_t id = graph.find_token(contract, symbol);
+    if (id == NO_TOKEN)
+        throw std::runtime_error(std::string("missing token ") + symbol);
+    return id;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("usage: path_finder_test <snapshot>\n");
+        return 1;
+    }
+
+    try {
+        auto graph = converter_graph::from_file(argv[1]);
+        path_finder finder(graph);
+
+        uint32_t tkna = token(graph, "aa", "TKNA");
+        uint32_t tknb = token(graph, "bb", "TKNB");
+        uint32_t bnt = token(graph, "bnt", "BNT");
+        uint32_t sys = token(graph, "eosio.token", "SYS");
+        uint32_t bnttkna = token(graph, "tknbntaa", "BNTTKNA");
+        uint32_t bnteos = token(graph, "bnt2eosrelay", "BNTEOS");
+
+        // disabled converters aren't loaded
+        CHECK(graph.find_token("tknaabbdd", "TKNAB") == NO_TOKEN, "disabled converter loaded");
+        CHECK(graph.converters.size() == 4, "unexpected converter count");
+
+        // formatting
+        CHECK(format_amount(15000, 4) == "1.5000", "format_amount");
+        CHECK(format_amount(5, 4) == "0.0005", "format_amount");
+        CHECK(parse_amount("1.5", 4) == 15000, "parse_amount");
+        CHECK(parse_amount("2.123456", 4) == 21234, "parse_amount");
+
+        // small amounts go through the direct converter, which has no fee
+        auto small = finder.find_best_path(tkna, tknb, parse_amount("1", 8));
+        CHECK(small.found && small.steps.size() == 1 && graph.converters[small.steps[0].converter].account == "cnvtab",
+              "small TKNA -> TKNB should use the direct converter");
+
+        // large amounts go through the deeper BNT converters
+        auto large = finder.find_best_path(tkna, tknb, parse_amount("500", 8));
+        CHECK(large.found && large.steps.size() == 2, "large TKNA -> TKNB should go through BNT");
+        CHECK(finder.build_memo(large, 12345678, "test1") == "1,cnvtaa BNT cnvtbb TKNB,0.12345678,test1", "memo format");
+
+        // two steps to a reserve of another converter
+        auto to_sys = finder.find_best_path(tkna, sys, parse_amount("10", 8));
+        CHECK(to_sys.found && to_sys.steps.size() == 2 && to_sys.steps[0].to_token == bnt, "TKNA -> SYS");
+
+        // the smart token can be the target but never an intermediate token
+        auto to_relay = finder.find_best_path(tknb, bnttkna, parse_amount("10", 8));
+        CHECK(to_relay.found && to_relay.steps.size() == 2, "TKNB -> BNTTKNA");
+
+        // BNTEOS purchases are disabled
+        CHECK(!finder.find_best_path(bnt, bnteos, parse_amount("10", 10)).found, "BNTEOS purchases are disabled");
+
+        // every pair of tokens against the exhaustive search
+        std::vector<path_query> queries;
+        for (uint32_t from = 0; from < graph.tokens.size(); ++from)
+            for (uint32_t to = 0; to < graph.tokens.size(); ++to)
+                for (const char* amount : { "0.01", "10", "5000" })
+                    if (from != to)
+                        queries.push_back({ from, to, parse_amount(amount, graph.tokens[from].precision) });
+
+        for (auto& query : queries) {
+            path_result path;
+            int64_t best = 0;
+            exhaustive_search(graph, finder, query.from, query.to, query.amount, DEFAULT_MAX_HOPS, path, best);
+
+            auto res = finder.find_best_path(query.from, query.to, query.amount);
+            CHECK(res.amount == best, ("best return of " + graph.tokens[query.from].symbol + " -> " + graph.tokens[query.to].symbol).c_str());
+            for (size_t i = 0; i + 1 < res.steps.size(); ++i) {
+                CHECK(res.steps[i].to_token != bnttkna, "smart token in the middle of a path");
+                CHECK(res.steps[i].converter != res.steps[i + 1].converter, "consecutive steps through the same converter");
+            }
+        }
+
+        // the threaded batch returns the same paths as single queries
+        auto results = finder.find_best_paths(queries, 4);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            auto res = finder.find_best_path(queries[i].from, queries[i].to, queries[i].amount);
+            CHECK(results[i].amount == res.amount && results[i].steps.size() == res.steps.size(), "threaded result differs");
+        }
+
+        printf("%zu queries checked\n", queries.size());
+    }
+    catch (const std::exception& e) {
+        printf("FAILED: %s\n", e.what());
+        return 1;
+    }
+
+    printf(failures == 0 ? "ok\n" : "path finder check failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/*
+    Finds the best conversion path between two tokens in a snapshot of the network's converters
+    and prints a ready to send conversion memo.
+
+    pathfinder <snapshot> <from contract> <from symbol> <to contract> <to symbol> <amount> [options]
+    pathfinder <snapshot> --queries <file> [options]
+
+    options -
+    --max-hops <n>          maximum number of conversion steps, 4 by default
+    --dest <account>        target account in the memo, "receiver" by default
+    --slippage <fraction>   the memo minimum return is the expected return reduced by this fraction, 0 by default
+    --threads <n>           threads used for --queries, all the hardware threads by default
+
+    --queries reads a query per line, in the same order as the arguments above
+    ("<from contract> <from symbol> <to contract> <to symbol> <amount>"), prints a memo per line
+    and the number of queries per second to stderr.
+    See converter_graph.hpp for the snapshot format.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "path_finder.hpp"
+
+struct options {
+    unsigned    max_hops = DEFAULT_MAX_HOPS;
+    std::string destination = "receiver";
+    double      slippage = 0;
+    unsigned    threads = 0;
+    std::string queries;
+};
+
+path_query make_query(const converter_graph& graph, const std::string& from_contract, const std::string& from_symbol,
+                      const std::string& to_contract, const std::string& to_symbol, const std::string& amount) {
+    path_query query;
+    query.from = graph.find_token(from_contract, from_symbol);
+    query.to = graph.find_token(to_contract, to_symbol);
+    if (query.from == NO_TOKEN)
+        throw std::runtime_error("unknown token " + from_contract + " " + from_symbol);
+    if (query.to == NO_TOKEN)
+        throw std::runtime_error("unknown token " + to_contract + " " + to_symbol);
+    query.amount = parse_amount(amount, graph.tokens[query.from].precision);
+    return query;
+}
+
+std::string result_memo(const path_finder& finder, const path_result& result, const options& opts) {
+    if (!result.found)
+        return "no path";
+    auto min_return = int64_t(result.amount * (1 - opts.slippage));
+    return finder.build_memo(result, min_return, opts.destination);
+}
+
+int main(int argc, char** argv) {
+    try {
+        options opts;
+        std::vector<std::string> args;
+        for (int i = 1; i < argc; ++i) {
+            auto value = [&]() {
+                if (i + 1 >= argc)
+                    throw std::runtime_error(std::string("missing value for ") + argv[i]);
+                return std::string(argv[++i]);
+            };
+
+            if (strcmp(argv[i], "--max-hops") == 0)
+                opts.max_hops = std::stoul(value());
+            else if (strcmp(argv[i], "--dest") == 0)
+                opts.destination = value();
+            else if (strcmp(argv[i], "--slippage") == 0)
+                opts.slippage = std::stod(value());
+            else if (strcmp(argv[i], "--threads") == 0)
+                opts.threads = std::stoul(value());
+            else if (strcmp(argv[i], "--queries") == 0)
+                opts.queries = value();
+            else
+                args.push_back(argv[i]);
+        }
+
+        if (args.size() != (opts.queries.empty() ? 6 : 1)) {
+            fprintf(stderr, "usage: pathfinder <snapshot> <from contract> <from symbol> <to contract> <to symbol> <amount> [options]\n"
+                            "       pathfinder <snapshot> --queries <file> [options]\n");
+            return 1;
+        }
+
+        auto graph = converter_graph::from_file(args[0]);
+        path_finder finder(graph, opts.max_hops);
+
+        if (opts.queries.empty()) {
+            auto query = make_query(graph, args[1], args[2], args[3], args[4], args[5]);
+            auto result = finder.find_best_path(query.from, query.to, query.amount);
+            printf("%s\n", result_memo(finder, result, opts).c_str());
+            if (result.found)
+                printf("return %s\n", format_amount(result.amount, graph.tokens[query.to].precision).c_str());
+            return result.found ? 0 : 2;
+        }
+
+        std::ifstream file(opts.queries);
+        if (!file)
+            throw std::runtime_error("cannot open " + opts.queries);
+
+        std::vector<path_query> queries;
+        for (std::string line; std::getline(file, line);) {
+            std::istringstream fields(line);
+            std::string from_contract, from_symbol, to_contract, to_symbol, amount;
+            if (fields >> from_contract >> from_symbol >> to_contract >> to_symbol >> amount)
+                queries.push_back(make_query(graph, from_contract, from_symbol, to_contract, to_symbol, amount));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto results = finder.find_best_paths(queries, opts.threads);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (auto& result : results)
+            printf("%s\n", result_memo(finder, result, opts).c_str());
+        fprintf(stderr, "%zu queries in %.3f s, %.0f queries per second\n", queries.size(), elapsed, queries.size() / elapsed);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,93 @@
+#include "bancor_fixture.hpp"
+#include "contracts.hpp"
+
+namespace sim {
+
+const token BNT     { "bnt"_n, symbol("BNT", 10) };
+const token SYS     { "eosio.token"_n, symbol("SYS", 4) };
+const token BNTEOS  { "bnt2eosrelay"_n, symbol("BNTEOS", 10) };
+const token TKNA    { "aa"_n, symbol("TKNA", 8) };
+const token TKNB    { "bb"_n, symbol("TKNB", 8) };
+const token TKNC    { "cc"_n, symbol("TKNC", 8) };
+const token BNTTKNA { "tknbntaa"_n, symbol("BNTTKNA", 10) };
+const token BNTTKNB { "tknbntbb"_n, symbol("BNTTKNB", 10) };
+const token BNTTKNC { "tknbntcc"_n, symbol("BNTTKNC", 10) };
+
+asset token::operator()(const char* amount) const {
+    std::string str(amount);
+    size_t dot = str.find('.');
+    std::string integer = str.substr(0, dot);
+    std::string fraction = dot == std::string::npos ? "" : str.substr(dot + 1);
+    eosio_assert(fraction.size() <= sym.precision(), "amount has too many decimal digits");
+    fraction.append(sym.precision() - fraction.size(), '0');
+    return asset(std::stoll(integer + fraction), sym);
+}
+
+bancor_fixture::bancor_fixture() {
+    for (auto account : { "eosio"_n, "bancorxoneos"_n, "thisisbancor"_n, "txrerouter"_n, "bnt2eoscnvrt"_n,
+                          "reporter1"_n, "reporter2"_n, "reporter3"_n, "reporter4"_n, "test1"_n, "test2"_n })
+        create_account(account);
+    for (auto& t : { BNT, SYS, BNTEOS, TKNA, TKNB, TKNC, BNTTKNA, BNTTKNB, BNTTKNC }) {
+        create_account(t.contract);
+        set_code(t.contract, token_apply);
+    }
+    set_code("bancorxoneos"_n, bancorx_apply);
+    set_code("thisisbancor"_n, bancor_network_apply);
+    set_code("txrerouter"_n, xtransfer_rerouter_apply);
+    set_code("bnt2eoscnvrt"_n, bancor_converter_apply);
+
+    // system token
+    setup("eosio.token"_n, "eosio.token"_n, "create"_n, "eosio"_n, SYS("10000000000.0000"));
+    setup("eosio"_n, "eosio.token"_n, "issue"_n, "eosio"_n, SYS("1000000000.0000"), "setup");
+
+    setup("bnt"_n, "bnt"_n, "create"_n, "bancorxoneos"_n, BNT("250000000"));
+    setup("bnt2eosrelay"_n, "bnt2eosrelay"_n, "create"_n, "bnt2eoscnvrt"_n, BNTEOS("250000000"));
+
+    // BNTEOS converter
+    setup("bnt2eoscnvrt"_n, "bnt2eoscnvrt"_n, "init"_n, BNTEOS.contract, BNTEOS.units(0), false, true, "thisisbancor"_n, false, uint64_t(0), uint64_t(0));
+    setup("bnt2eoscnvrt"_n, "bnt2eoscnvrt"_n, "setreserve"_n, BNT.contract, BNT.units(0), uint64_t(500), true);
+    setup("bnt2eoscnvrt"_n, "bnt2eoscnvrt"_n, "setreserve"_n, SYS.contract, SYS.units(0), uint64_t(500), true);
+    setup("eosio"_n, "eosio.token"_n, "transfer"_n, "eosio"_n, "bnt2eoscnvrt"_n, SYS("10000"), "setup");
+    setup("bancorxoneos"_n, "bnt"_n, "issue"_n, "bnt2eoscnvrt"_n, BNT("90000"), "setup");
+    setup("bnt2eoscnvrt"_n, "bnt2eosrelay"_n, "issue"_n, "bnt2eoscnvrt"_n, BNTEOS("20000"), "setup");
+    setup("bnt2eoscnvrt"_n, "bnt2eoscnvrt"_n, "resync"_n);
+    setup("thisisbancor"_n, "thisisbancor"_n, "regconverter"_n, "bnt2eoscnvrt"_n);
+
+    // BancorX
+    setup("bancorxoneos"_n, "bancorxoneos"_n, "init"_n, BNT.contract, uint64_t(2), uint64_t(1), uint64_t(100000000000000),
+          uint64_t(10000000000000000), uint64_t(10000000000000000));
+    for (auto reporter : { "reporter1"_n, "reporter2"_n, "reporter3"_n })
+        setup("bancorxoneos"_n, "bancorxoneos"_n, "addreporter"_n, reporter);
+    setup("bancorxoneos"_n, "bancorxoneos"_n, "enablext"_n, true);
+    setup("bancorxoneos"_n, "bancorxoneos"_n, "enablerpt"_n, true);
+
+    setup("bancorxoneos"_n, "bnt"_n, "issue"_n, "test1"_n, BNT("10000"), "test money");
+    setup("bancorxoneos"_n, "bnt"_n, "issue"_n, "reporter1"_n, BNT("100"), "test money");
+    setup("eosio"_n, "eosio.token"_n, "transfer"_n, "eosio"_n, "test1"_n, SYS("1000"), "test money");
+
+    add_converter("cnvtaa"_n, TKNA, BNTTKNA, 0);
+    add_converter("cnvtbb"_n, TKNB, BNTTKNB, 1);
+    add_converter("cnvtcc"_n, TKNC, BNTTKNC, 0);
+}
+
+void bancor_fixture::add_converter(name converter, const token& reserve, const token& smart, uint64_t fee) {
+    create_account(converter);
+    set_code(converter, bancor_converter_apply);
+
+    setup(reserve.contract, reserve.contract, "create"_n, reserve.contract, reserve("1000000000"));
+    setup(smart.contract, smart.contract, "create"_n, converter, smart("250000000"));
+
+    setup(converter, converter, "init"_n, smart.contract, smart.units(0), true, true, "thisisbancor"_n, false, uint64_t(30), fee);
+    setup(converter, converter, "setreserve"_n, BNT.contract, BNT.units(0), uint64_t(500), true);
+    setup(converter, converter, "setreserve"_n, reserve.contract, reserve.units(0), uint64_t(500), true);
+
+    setup(reserve.contract, reserve.contract, "issue"_n, converter, reserve("100000"), "setup");
+    setup(converter, smart.contract, "issue"_n, converter, smart("100000"), "setup");
+    setup("bancorxoneos"_n, BNT.contract, "issue"_n, converter, BNT("100000"), "setup");
+
+    // the smart token was issued directly to the converter, sync its tracked supply
+    setup(converter, converter, "resync"_n);
+    setup("thisisbancor"_n, "thisisbancor"_n, "regconverter"_n, converter);
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "chain.hpp"
+
+namespace sim {
+
+using eosio::symbol;
+
+// a token of the test deployment
+struct token {
+    name   contract;
+    symbol sym;
+
+    // an amount of the token from a decimal number, e.g. "1.5"
+    asset operator()(const char* amount) const;
+    asset units(int64_t amount) const { return asset(amount, sym); }
+};
+
+extern const token BNT;
+extern const token SYS;
+extern const token BNTEOS;
+extern const token TKNA;
+extern const token TKNB;
+extern const token TKNC;
+extern const token BNTTKNA;
+extern const token BNTTKNB;
+extern const token BNTTKNC;
+
+/*
+    A chain with the contracts deployed and set up the same way
+    migrations/5_deploy_bancor_contracts.js sets up the test network -
+
+    bnt2eoscnvrt    BNT and SYS reserves, BNTEOS smart token, no fee
+    cnvtaa          BNT and TKNA reserves, BNTTKNA smart token, no fee
+    cnvtbb          BNT and TKNB reserves, BNTTKNB smart token, 0.1% fee
+    cnvtcc          BNT and TKNC reserves, BNTTKNC smart token, no fee
+
+    BancorX requires 2 of its 3 reporters, test1 holds 10000 BNT and 1000 SYS.
+*/
+class bancor_fixture : public chain {
+    public:
+        bancor_fixture();
+
+        transaction_result transfer(const token& t, name from, name to, asset quantity, const std::string& memo) {
+            return push_action(from, t.contract, "transfer"_n, from, to, quantity, memo);
+        }
+
+        int64_t balance(const token& t, name owner) const { return chain::balance(t.contract, owner, t.sym.code()); }
+        int64_t supply(const token& t) const { return chain::supply(t.contract, t.sym.code()); }
+
+        // pushes an action that has to succeed, throws otherwise
+        template<typename... Args>
+        void setup(name actor, name account, name action, const Args&... args) {
+            auto res = push_action(actor, account, action, args...);
+            if (!res.succeeded)
+                throw std::runtime_error("setup action " + account.to_string() + "::" + action.to_string() + " failed: " + res.error);
+        }
+
+    private:
+        void add_converter(name converter, const token& reserve, const token& smart, uint64_t fee);
+};
+
+}
@@ -0,0 +1,368 @@
+#include "chain.hpp"
+
+using namespace eosio::native;
+
+namespace sim {
+
+// the ram billed for a row
+static int64_t row_ram(const db_row& row) {
+    return row.data.size() + ROW_RAM_OVERHEAD + row.secondary.size() * SECONDARY_RAM_OVERHEAD;
+}
+
+static void missing_authority(uint64_t account) {
+    throw std::runtime_error("missing authority of " + name(account).to_string());
+}
+
+const std::string& event::operator[](const std::string& key) const {
+    static const std::string empty;
+    auto field = fields.find(key);
+    return field != fields.end() ? field->second : empty;
+}
+
+double event::number(const std::string& key) const {
+    return std::stod((*this)[key]);
+}
+
+// parses a line written by event_writer, values are quoted strings and aren't escaped
+static bool parse_event(const std::string& line, event& res) {
+    if (line.size() < 2 || line.front() != '{' || line.back() != '}')
+        return false;
+
+    size_t pos = 1;
+    auto quoted = [&](std::string& out) {
+        if (pos >= line.size() || line[pos] != '"')
+            return false;
+        size_t end = line.find('"', pos + 1);
+        if (end == std::string::npos)
+            return false;
+        out = line.substr(pos + 1, end - pos - 1);
+        pos = end + 1;
+        return true;
+    };
+
+    while (pos < line.size() - 1) {
+        std::string key, value;
+        if (!quoted(key) || line[pos++] != ':' || !quoted(value))
+            return false;
+        res.fields[key] = value;
+        if (line[pos] == ',')
+            ++pos;
+    }
+    return true;
+}
+
+std::vector<event> transaction_result::events(const char* etype) const {
+    std::vector<event> res;
+    for (auto& trace : traces) {
+        size_t start = 0;
+        while (start < trace.console.size()) {
+            size_t end = trace.console.find('\n', start);
+            if (end == std::string::npos)
+                end = trace.console.size();
+
+            event e;
+            if (parse_event(trace.console.substr(start, end - start), e) && (!etype || e["etype"] == etype))
+                res.push_back(std::move(e));
+            start = end + 1;
+        }
+    }
+    return res;
+}
+
+chain::chain() : _now(1559347200ull * 1000000) {
+    eosio_assert(active_host() == nullptr, "only one chain can be active at a time");
+    active_host() = this;
+}
+
+chain::~chain() {
+    active_host() = nullptr;
+}
+
+void chain::create_account(name account) {
+    eosio_assert(!is_account(account.value), "account already exists");
+    _accounts[account.value];
+}
+
+void chain::set_code(name account, apply_function apply) {
+    auto existing = _accounts.find(account.value);
+    eosio_assert(existing != _accounts.end(), "account does not exist");
+    existing->second.apply = apply;
+}
+
+transaction_result chain::push_transaction(const std::vector<eosio::action>& actions) {
+    eosio_assert(_contexts.empty(), "transactions can't be pushed by an action");
+
+    transaction_result res;
+    try {
+        for (auto& act : actions) {
+            eosio_assert(is_account(act.account.value), "action's account does not exist");
+            eosio_assert(!act.authorization.empty(), "action has no authorization");
+            for (auto& auth : act.authorization)
+                eosio_assert(is_account(auth.actor.value), "authorizing account does not exist");
+
+            execute_action(act, 0, res);
+        }
+    }
+    catch (const std::exception& e) {
+        _contexts.clear();
+        print_console() = nullptr;
+        rollback();
+
+        res.succeeded = false;
+        res.error = e.what();
+        res.traces.clear();
+        return res;
+    }
+
+    _undo.clear();
+    return res;
+}
+
+void chain::execute_action(const eosio::action& act, uint32_t depth, transaction_result& res) {
+    action_context ctx{ &act, act.account, { act.account }, {} };
+    _contexts.push_back(&ctx);
+
+    // accounts notified while the action runs are added to the end of the list
+    for (size_t i = 0; i < ctx.notified.size(); ++i) {
+        ctx.receiver = ctx.notified[i];
+        std::string console;
+
+        auto account = _accounts.find(ctx.receiver.value);
+        if (account->second.apply) {
+            print_console() = record_traces ? &console : nullptr;
+            try {
+                account->second.apply(ctx.receiver.value, act.account.value, act.name.value);
+            }
+            catch (const action_exit&) {}
+            print_console() = nullptr;
+        }
+
+        if (record_traces)
+            res.traces.push_back({ ctx.receiver, act, depth, std::move(console) });
+    }
+
+    _contexts.pop_back();
+
+    if (!ctx.inline_actions.empty())
+        eosio_assert(depth < max_inline_action_depth, "max inline action depth per transaction reached");
+    for (auto& inline_action : ctx.inline_actions)
+        execute_action(inline_action, depth + 1, res);
+}
+
+chain::action_context& chain::context() {
+    eosio_assert(!_contexts.empty(), "no action is executing");
+    return *_contexts.back();
+}
+
+uint64_t chain::current_receiver() {
+    return _contexts.empty() ? 0 : _contexts.back()->receiver.value;
+}
+
+const std::vector<char>& chain::action_data() {
+    return context().act->data;
+}
+
+bool chain::has_auth(uint64_t account) {
+    for (auto& auth : context().act->authorization)
+        if (auth.actor.value == account)
+            return true;
+    return false;
+}
+
+void chain::require_recipient(uint64_t account) {
+    auto& ctx = context();
+    eosio_assert(is_account(account), "can not notify a non-existent account");
+    if (std::find(ctx.notified.begin(), ctx.notified.end(), name(account)) == ctx.notified.end())
+        ctx.notified.push_back(name(account));
+}
+
+void chain::send_inline(const eosio::action& act) {
+    auto& ctx = context();
+    eosio_assert(is_account(act.account.value), "inline action's code account does not exist");
+    for (auto& auth : act.authorization)
+        if (auth.actor != ctx.receiver && !has_auth(auth.actor.value))
+            missing_authority(auth.actor.value);
+
+    ctx.inline_actions.push_back(act);
+}
+
+bool chain::is_account(uint64_t account) {
+    return _accounts.count(account) > 0;
+}
+
+const db_row* chain::find_row(const table_id& table, uint64_t primary) const {
+    auto t = _tables.find(table);
+    if (t == _tables.end())
+        return nullptr;
+    auto row = t->second.rows.find(primary);
+    return row != t->second.rows.end() ? &row->second : nullptr;
+}
+
+const db_row* chain::db_find(const table_id& table, uint64_t primary) {
+    return find_row(table, primary);
+}
+
+bool chain::db_lower_bound(const table_id& table, uint64_t primary, uint64_t& found) {
+    auto t = _tables.find(table);
+    if (t == _tables.end())
+        return false;
+    auto row = t->second.rows.lower_bound(primary);
+    if (row == t->second.rows.end())
+        return false;
+    found = row->first;
+    return true;
+}
+
+bool chain::db_last(const table_id& table, uint64_t& found) {
+    auto t = _tables.find(table);
+    if (t == _tables.end() || t->second.rows.empty())
+        return false;
+    found = t->second.rows.rbegin()->first;
+    return true;
+}
+
+void chain::db_store(const table_id& table, uint64_t primary, db_row row) {
+    auto& ctx = context();
+    eosio_assert(table.code == ctx.receiver.value, "db access violation");
+    eosio_assert(is_account(row.payer), "ram payer account does not exist");
+
+    // billing another account requires its authorization, and isn't allowed in notifications
+    const db_row* existing = find_row(table, primary);
+    int64_t billed = row_ram(row) - (existing && existing->payer == row.payer ? row_ram(*existing) : 0);
+    if (row.payer != ctx.receiver.value && billed > 0) {
+        eosio_assert(ctx.receiver == ctx.act->account, "unprivileged contract cannot increase RAM usage of another account within a notify context");
+        if (!has_auth(row.payer))
+            missing_authority(row.payer);
+    }
+
+    put_row(table, primary, &row, true);
+}
+
+void chain::db_remove(const table_id& table, uint64_t primary) {
+    eosio_assert(table.code == context().receiver.value, "db access violation");
+    eosio_assert(find_row(table, primary) != nullptr, "row does not exist");
+    put_row(table, primary, nullptr, true);
+}
+
+bool chain::db_idx_lower_bound(const table_id& table, size_t index, uint64_t secondary, uint64_t primary,
+                               uint64_t& found_secondary, uint64_t& found_primary) {
+    auto t = _tables.find(table);
+    if (t == _tables.end() || index >= t->second.indexes.size())
+        return false;
+
+    auto& entries = t->second.indexes[index];
+    auto entry = entries.lower_bound({ secondary, primary });
+    if (entry == entries.end())
+        return false;
+    found_secondary = entry->first;
+    found_primary = entry->second;
+    return true;
+}
+
+// replaces, inserts or (for a null row) removes a row, updating the indexes and the billed ram
+void chain::put_row(const table_id& table, uint64_t primary, db_row* row, bool record_undo) {
+    auto& t = _tables[table];
+    auto existing = t.rows.find(primary);
+    bool existed = existing != t.rows.end();
+
+    if (record_undo)
+        _undo.push_back({ table, primary, existed, existed ? existing->second : db_row() });
+
+    if (existed) {
+        bill_ram(existing->second.payer, -row_ram(existing->second));
+        for (size_t i = 0; i < existing->second.secondary.size(); ++i)
+            t.indexes[i].erase({ existing->second.secondary[i], primary });
+    }
+
+    if (row) {
+        bill_ram(row->payer, row_ram(*row));
+        if (t.indexes.size() < row->secondary.size())
+            t.indexes.resize(row->secondary.size());
+        for (size_t i = 0; i < row->secondary.size(); ++i)
+            t.indexes[i].insert({ row->secondary[i], primary });
+
+        if (existed)
+            existing->second = std::move(*row);
+        else
+            t.rows.emplace(primary, std::move(*row));
+    }
+    else {
+        if (existed)
+            t.rows.erase(existing);
+        if (t.rows.empty())
+            _tables.erase(table);
+    }
+}
+
+void chain::bill_ram(uint64_t payer, int64_t delta) {
+    auto account = _accounts.find(payer);
+    if (account != _accounts.end())
+        account->second.ram_usage += delta;
+}
+
+void chain::rollback() {
+    for (auto entry = _undo.rbegin(); entry != _undo.rend(); ++entry)
+        put_row(entry->table, entry->primary, entry->existed ? &entry->row : nullptr, false);
+    _undo.clear();
+}
+
+void chain::store_row(const table_id& table, uint64_t primary, std::vector<char> data, name payer) {
+    db_row row;
+    row.data = std::move(data);
+    row.payer = payer.value;
+    put_row(table, primary, &row, false);
+}
+
+size_t chain::row_count(name code, uint64_t scope, name table) const {
+    auto t = _tables.find({ code.value, scope, table.value });
+    return t != _tables.end() ? t->second.rows.size() : 0;
+}
+
+int64_t chain::ram_usage(name account) const {
+    auto existing = _accounts.find(account.value);
+    return existing != _accounts.end() ? existing->second.ram_usage : 0;
+}
+
+int64_t chain::balance(name token, name owner, symbol_code symbol) const {
+    asset res;
+    return get_row(token, owner.value, "accounts"_n, symbol.raw(), res) ? res.amount : 0;
+}
+
+int64_t chain::supply(name token, symbol_code symbol) const {
+    asset res;     // the first field of the stats row
+    return get_row(token, symbol.raw(), "stat"_n, symbol.raw(), res) ? res.amount : 0;
+}
+
+int64_t chain::total_balance(name token, symbol_code symbol) const {
+    int64_t res = 0;
+    for (auto& t : _tables) {
+        if (t.first.code != token.value || t.first.table != "accounts"_n.value)
+            continue;
+        auto row = t.second.rows.find(symbol.raw());
+        if (row != t.second.rows.end())
+            res += eosio::unpack<asset>(row->second.data).amount;
+    }
+    return res;
+}
+
+uint64_t chain::state_digest() const {
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&](const void* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<const uint8_t*>(data)[i];
+            hash *= 1099511628211ull;
+        }
+    };
+
+    for (auto& t : _tables) {
+        add(&t.first, sizeof(t.first));
+        for (auto& row : t.second.rows) {
+            add(&row.first, sizeof(row.first));
+            add(&row.second.payer, sizeof(row.second.payer));
+            add(row.second.data.data(), row.second.data.size());
+        }
+    }
+    return hash;
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <eosiolib/eosio.hpp>
+
+/*
+    An in-memory chain that runs the contracts natively.
+
+    Contracts are registered as apply functions and run the same way nodeos runs them -
+    an action runs at its account, then at every account it notified with require_recipient,
+    then the inline actions sent by all of them run, depth first.
+    Authorizations are trusted (there are no keys), require_auth passes for the actors
+    listed in the action's authorization and inline actions can only be authorized by
+    the sending contract or by the actors of the action that sent them.
+    A failed transaction rolls back every table change it made.
+
+    Block time only advances with produce_blocks, 500ms per block.
+*/
+
+namespace sim {
+
+using eosio::name;
+using eosio::asset;
+using eosio::symbol_code;
+
+typedef void (*apply_function)(uint64_t receiver, uint64_t code, uint64_t action);
+
+#define BLOCK_INTERVAL_US 500000
+
+// ram billed per row in addition to its data and per secondary index entry, approximately what nodeos bills
+#define ROW_RAM_OVERHEAD 112
+#define SECONDARY_RAM_OVERHEAD 112
+
+// a single line json event printed by a contract, e.g. {"version":"1.2","etype":"conversion",...}
+struct event {
+    std::map<std::string, std::string> fields;
+
+    const std::string& operator[](const std::string& key) const;
+    double number(const std::string& key) const;
+};
+
+struct action_trace {
+    name          receiver;
+    eosio::action act;
+    uint32_t      depth;    // 0 for the actions of the transaction, inline actions are one deeper than their sender
+    std::string   console;
+};
+
+struct transaction_result {
+    bool                      succeeded = true;
+    std::string               error;    // the assertion message of a failed transaction
+    std::vector<action_trace> traces;   // in execution order, empty for failed transactions
+
+    // the events printed by the actions, optionally only of one type
+    std::vector<event> events(const char* etype = nullptr) const;
+};
+
+class chain : public eosio::native::host {
+    public:
+        chain();
+        ~chain();
+
+        chain(const chain&) = delete;
+        chain& operator=(const chain&) = delete;
+
+        void create_account(name account);
+        void set_code(name account, apply_function apply);
+
+        transaction_result push_transaction(const std::vector<eosio::action>& actions);
+
+        // pushes a single action authorized by actor, the arguments are serialized in order
+        template<typename... Args>
+        transaction_result push_action(name actor, name account, name action, const Args&... args) {
+            return push_transaction({ eosio::action(eosio::permission_level(actor, "active"_n), account, action, std::make_tuple(arg(args)...)) });
+        }
+
+        void produce_blocks(uint32_t count = 1) { _now += uint64_t(count) * BLOCK_INTERVAL_US; }
+        uint64_t now() const { return _now; }
+
+        // reads a row directly, returns false if it doesn't exist
+        template<typename T>
+        bool get_row(name code, uint64_t scope, name table, uint64_t primary, T& res) const {
+            auto row = find_row({ code.value, scope, table.value }, primary);
+            if (!row)
+                return false;
+            res = eosio::unpack<T>(row->data);
+            return true;
+        }
+
+        // writes a row directly, without secondary index entries, like a row stored by an older version of a contract
+        template<typename T>
+        void set_row(name code, uint64_t scope, name table, uint64_t primary, const T& row, name payer) {
+            store_row({ code.value, scope, table.value }, primary, eosio::pack(row), payer);
+        }
+
+        size_t row_count(name code, uint64_t scope, name table) const;
+        int64_t ram_usage(name account) const;
+
+        // token balance and supply of an eosio.token compatible contract, zero if there's no row
+        int64_t balance(name token, name owner, symbol_code symbol) const;
+        int64_t supply(name token, symbol_code symbol) const;
+        // the sum of the balances of every account
+        int64_t total_balance(name token, symbol_code symbol) const;
+
+        // a hash of every table row, equal digests mean equal table contents
+        uint64_t state_digest() const;
+
+        uint32_t max_inline_action_depth = 4;   // the nodeos default
+        bool     record_traces = true;          // traces and consoles are only kept when set
+
+        // host
+        uint64_t current_receiver() override;
+        const std::vector<char>& action_data() override;
+        bool has_auth(uint64_t account) override;
+        void require_recipient(uint64_t account) override;
+        void send_inline(const eosio::action& act) override;
+        bool is_account(uint64_t account) override;
+        uint64_t current_time() override { return _now; }
+
+        const eosio::native::db_row* db_find(const eosio::native::table_id& table, uint64_t primary) override;
+        bool db_lower_bound(const eosio::native::table_id& table, uint64_t primary, uint64_t& found) override;
+        bool db_last(const eosio::native::table_id& table, uint64_t& found) override;
+        void db_store(const eosio::native::table_id& table, uint64_t primary, eosio::native::db_row row) override;
+        void db_remove(const eosio::native::table_id& table, uint64_t primary) override;
+        bool db_idx_lower_bound(const eosio::native::table_id& table, size_t index, uint64_t secondary, uint64_t primary,
+                                uint64_t& found_secondary, uint64_t& found_primary) override;
+
+    private:
+        struct account_state {
+            apply_function apply = nullptr;
+            int64_t        ram_usage = 0;
+        };
+
+        struct table_state {
+            std::map<uint64_t, eosio::native::db_row> rows;
+            std::vector<std::set<std::pair<uint64_t, uint64_t>>> indexes;  // (secondary, primary) entries of every secondary index
+        };
+
+        // an action executing at one of its receivers
+        struct action_context {
+            const eosio::action*       act;
+            name                       receiver;
+            std::vector<name>          notified;   // the action's account first, then the accounts notified in order
+            std::vector<eosio::action> inline_actions;
+        };
+
+        // the previous state of a changed row, to roll back failed transactions
+        struct undo_entry {
+            eosio::native::table_id table;
+            uint64_t                primary;
+            bool                    existed;
+            eosio::native::db_row   row;
+        };
+
+        std::unordered_map<uint64_t, account_state>       _accounts;
+        std::map<eosio::native::table_id, table_state>    _tables;
+        std::vector<action_context*>                      _contexts;
+        std::vector<undo_entry>                           _undo;
+        uint64_t                                          _now;
+
+        // converts string literals, so they're serialized as strings
+        template<typename T>
+        static const T& arg(const T& value) { return value; }
+        static std::string arg(const char* value) { return value; }
+
+        action_context& context();
+        const eosio::native::db_row* find_row(const eosio::native::table_id& table, uint64_t primary) const;
+        void store_row(const eosio::native::table_id& table, uint64_t primary, std::vector<char> data, name payer);
+
+        void execute_action(const eosio::action& act, uint32_t depth, transaction_result& res);
+        void put_row(const eosio::native::table_id& table, uint64_t primary, eosio::native::db_row* row, bool record_undo);
+        void bill_ram(uint64_t payer, int64_t delta);
+        void rollback();
+};
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// the apply functions of the contracts, each contract is compiled with apply renamed (see CMakeLists.txt)
+extern "C" {
+    [[noreturn]] void bancor_converter_apply(uint64_t receiver, uint64_t code, uint64_t action);
+    [[noreturn]] void bancor_network_apply(uint64_t receiver, uint64_t code, uint64_t action);
+    [[noreturn]] void bancorx_apply(uint64_t receiver, uint64_t code, uint64_t action);
+    void token_apply(uint64_t receiver, uint64_t code, uint64_t action);
+    void xtransfer_rerouter_apply(uint64_t receiver, uint64_t code, uint64_t action);
+}
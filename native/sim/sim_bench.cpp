@@ -0,0 +1,71 @@
+/*
+    sim_bench [conversions]
+
+    Measures the conversions per second of the contracts running natively on the in-memory chain,
+    with traces off. Every case runs whole transactions - the token transfer to the network,
+    its notifications and every inline action of the path.
+
+    Build with -DCMAKE_BUILD_TYPE=RelWithDebInfo and profile with
+    perf record -g build/sim/sim_bench && perf report
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "bancor_fixture.hpp"
+
+using namespace sim;
+
+struct bench_case {
+    const char*  name;
+    const token& from;
+    const token& to;
+    const char*  path;
+    const char*  back;      // the reverse path, so balances stay stable
+};
+
+static const bench_case CASES[] = {
+    { "1 hop, BNT -> TKNA", BNT, TKNA, "cnvtaa TKNA", "cnvtaa BNT" },
+    { "1 hop, with fee", BNT, TKNB, "cnvtbb TKNB", "cnvtbb BNT" },
+    { "2 hops, TKNA -> TKNB", TKNA, TKNB, "cnvtaa BNT cnvtbb TKNB", "cnvtbb BNT cnvtaa TKNA" },
+    { "smart token purchase", BNT, BNTTKNC, "cnvtcc BNTTKNC", "cnvtcc BNT" }
+};
+
+int main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    try {
+        bancor_fixture chain;
+        chain.record_traces = false;
+        for (auto t : { &TKNA, &TKNB, &TKNC })
+            chain.setup(t->contract, t->contract, "issue"_n, "test1"_n, (*t)("10000"), "test money");
+
+        for (auto& c : CASES) {
+            std::string memo = std::string("1,") + c.path + ",0.00000001,test1";
+            std::string back = std::string("1,") + c.back + ",0.00000001,test1";
+            asset quantity = c.from("1");
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < count; i += 2) {
+                int64_t before = chain.balance(c.to, "test1"_n);
+                auto res = chain.transfer(c.from, "test1"_n, "thisisbancor"_n, quantity, memo);
+                if (!res.succeeded)
+                    throw std::runtime_error(std::string(c.name) + ": " + res.error);
+
+                asset received = c.to.units(chain.balance(c.to, "test1"_n) - before);
+                res = chain.transfer(c.to, "test1"_n, "thisisbancor"_n, received, back);
+                if (!res.succeeded)
+                    throw std::runtime_error(std::string(c.name) + ": " + res.error);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("%-24s %10.0f conversions/s %8.2f us/conversion\n", c.name, count / seconds, seconds * 1e6 / count);
+        }
+    }
+    catch (const std::exception& e) {
+        printf("FAILED: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,804 @@
+/*
+    sim_test --scenarios
+    sim_test --properties [seed] [conversions]
+
+    Runs the contracts on the in-memory chain, exits with 1 on failure.
+
+    The scenarios follow the mocha specs in test/, the properties run random conversions
+    through every converter with all the memo versions and check after every conversion that -
+    - the return matches the network quote
+    - a failed conversion leaves every table unchanged
+    and periodically that every token's balances add up to its supply, and that the
+    tracked converter balances and smart token supplies match the token contracts.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bancor_fixture.hpp"
+#include "contracts.hpp"
+#include "Common/common.hpp"
+#include "BancorConverter/BancorConverter.hpp"
+#include "BancorX/BancorX.hpp"
+
+using namespace sim;
+
+static int failures = 0;
+
+#define CHECK(test, msg) if (!(test)) { printf("FAILED: %s (line %d)\n", msg, __LINE__); ++failures; }
+
+static bool failed_with(const transaction_result& res, const char* error) {
+    return !res.succeeded && res.error.find(error) != std::string::npos;
+}
+
+// formats an amount the way the memo parser reads it, e.g. 1.50000000
+static std::string decimal(const asset& quantity) {
+    uint8_t precision = quantity.symbol.precision();
+    std::string digits = std::to_string(quantity.amount);
+    if (digits.size() <= precision)
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    if (precision > 0)
+        digits.insert(digits.size() - precision, ".");
+    return digits;
+}
+
+static std::string packed_memo(const std::string& path, int64_t min_return, name target) {
+    memo_structure data;
+    parse_path(data, path);
+    return build_packed_memo(data, min_return, target);
+}
+
+// the (from, to) pairs of the executed token transfers, in execution order
+static std::vector<std::pair<name, name>> transfers(const transaction_result& res) {
+    std::vector<std::pair<name, name>> pairs;
+    for (auto& trace : res.traces) {
+        if (trace.act.name != "transfer"_n || trace.receiver != trace.act.account)
+            continue;
+        auto data = trace.act.data_as<std::tuple<name, name, asset, std::string>>();
+        pairs.push_back({ std::get<0>(data), std::get<1>(data) });
+    }
+    return pairs;
+}
+
+static void conversions() {
+    bancor_fixture chain;
+
+    auto simple = chain.transfer(BNT, "test1"_n, "thisisbancor"_n, BNT("2"), "1,cnvtaa TKNA,0.100,test1");
+    CHECK(simple.succeeded, "simple convert failed");
+    CHECK(simple.events("conversion").size() == 1, "unexpected number of conversions");
+    CHECK(simple.events("price_data").size() == 2 && simple.events("price_data")[0]["reserve_ratio"] == "0.5", "unexpected reserve ratio");
+
+    // the returns asserted by the network spec, which runs the same conversions
+    auto two_hop = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNT cnvtbb TKNB,0.100,test1");
+    auto events = two_hop.events("conversion");
+    CHECK(two_hop.succeeded && events.size() == 2, "2 hop convert failed");
+    if (events.size() == 2) {
+        CHECK(events[0]["return"] == "1.0000299998", "unexpected first hop return");
+        CHECK(events[1]["return"] == "0.99802095", "unexpected second hop return");
+        CHECK(events[1]["conversion_fee"] == "0.00199904", "unexpected second hop fee");
+    }
+
+    // the intermediate return goes directly to the next converter
+    std::vector<std::pair<name, name>> expected = {
+        { "test1"_n, "thisisbancor"_n }, { "thisisbancor"_n, "cnvtaa"_n }, { "cnvtaa"_n, "cnvtbb"_n }, { "cnvtbb"_n, "test1"_n }
+    };
+    CHECK(transfers(two_hop) == expected, "unexpected token transfers");
+
+    chain.setup("aa"_n, "aa"_n, "issue"_n, "test1"_n, TKNA("100"), "test money");
+
+    // a converter can't send the return of a step to itself
+    for (auto memo : { std::string("1,cnvtaa BNT cnvtaa BNTTKNA,0.0000000001,test1"), std::string("1.1,0,cnvtaa BNT cnvtaa BNTTKNA,0.0000000001,test1"),
+                       packed_memo("cnvtaa BNT cnvtaa BNTTKNA", 1, "test1"_n) })
+        CHECK(failed_with(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), memo), "consecutive steps cannot use the same converter"),
+              "consecutive steps through the same converter accepted");
+
+    const std::string path = "cnvtaa BNT cnvtbb TKNB";
+    std::string cursor_memo = "1.1,0," + path + ",0.100,test1";
+    auto cursor = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), cursor_memo);
+    events = cursor.events("conversion");
+    CHECK(cursor.succeeded && events.size() == 2, "hop cursor convert failed");
+    if (events.size() == 2) {
+        CHECK(events[0]["memo"] == cursor_memo, "unexpected first hop memo");
+        CHECK(events[1]["memo"] == "1.1,1," + path + ",0.100,test1", "unexpected second hop memo");
+    }
+
+    auto packed = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), packed_memo(path, 10000000, "test1"_n));
+    events = packed.events("conversion");
+    CHECK(packed.succeeded && events.size() == 2 && events[1]["to_symbol"] == "TKNB", "packed memo convert failed");
+
+    // failed conversions don't change any table
+    uint64_t digest = chain.state_digest();
+    int64_t tkna = chain.balance(TKNA, "test1"_n);
+
+    auto below_min = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), packed_memo("cnvtaa BNT", 100000000000000, "test1"_n));
+    CHECK(failed_with(below_min, "below min return"), "packed memo min return not enforced");
+    auto unknown = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNT cnvtbb TKNX,0.1,test1");
+    CHECK(failed_with(unknown, "reserve not found"), "unknown symbol in a later step accepted");
+    auto middle = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNTTKNA cnvtaa BNT,0.1,test1");
+    CHECK(failed_with(middle, "smart token must be final currency"), "smart token in a middle step accepted");
+    auto other = chain.transfer(BNT, "test1"_n, "thisisbancor"_n, BNT("1"), "1,cnvtaa TKNA,0.1,test2");
+    CHECK(failed_with(other, "the destination account must by either the sender"), "conversion to another account accepted");
+    auto non_converter = chain.transfer(BNT, "test1"_n, "thisisbancor"_n, BNT("1"), "1,test2 TKNA,0.1,test1");
+    CHECK(failed_with(non_converter, "converter doesn't exist"), "non converter in the path accepted");
+    auto disabled = chain.transfer(BNT, "test1"_n, "thisisbancor"_n, BNT("1"), "1,bnt2eoscnvrt BNTEOS,0.1,test1");
+    CHECK(failed_with(disabled, "'to' token purchases disabled"), "disabled smart token purchase accepted");
+
+    CHECK(chain.state_digest() == digest, "failed conversions changed the tables");
+    CHECK(chain.balance(TKNA, "test1"_n) == tkna, "failed conversions changed the balance");
+}
+
+struct conversion_item {
+    std::string path;
+    asset       quantity;
+    asset       min_return;
+    name        destination;
+};
+
+// converter rows stored before the balances were tracked, without the trailing tracked fields
+struct legacy_settings {
+    name     smart_contract;
+    asset    smart_currency;
+    bool     smart_enabled;
+    bool     enabled;
+    name     network;
+    bool     require_balance;
+    uint64_t max_fee;
+    uint64_t fee;
+};
+
+struct legacy_reserve {
+    name     contract;
+    asset    currency;
+    uint64_t ratio;
+    bool     p_enabled;
+};
+
+static void legacy_converter() {
+    bancor_fixture chain;
+    chain.setup("aa"_n, "aa"_n, "issue"_n, "test1"_n, TKNA("100"), "test money");
+
+    BancorConverter::settings_t settings;
+    chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "settings"_n, "settings"_n.value, settings);
+    chain.set_row("cnvtaa"_n, "cnvtaa"_n.value, "settings"_n, "settings"_n.value,
+                  legacy_settings{ settings.smart_contract, settings.smart_currency, settings.smart_enabled, settings.enabled, settings.network,
+                                   settings.require_balance, settings.max_fee, settings.fee }, "cnvtaa"_n);
+    for (auto reserve : { &BNT, &TKNA }) {
+        BancorConverter::reserve_t row;
+        chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "reserves"_n, reserve->sym.code().raw(), row);
+        chain.set_row("cnvtaa"_n, "cnvtaa"_n.value, "reserves"_n, reserve->sym.code().raw(),
+                      legacy_reserve{ row.contract, row.currency, row.ratio, row.p_enabled }, "cnvtaa"_n);
+        CHECK(chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "reserves"_n, reserve->sym.code().raw(), row) && !row.balance.has_value(),
+              "legacy reserve row read with a balance");
+    }
+
+    // untracked balances and supply are read from the token contracts
+    auto quote = chain.push_action("test1"_n, "thisisbancor"_n, "quote"_n, std::string("cnvtaa BNT"), TKNA("1"));
+    auto conversion = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNT,0.0000000001,test1");
+    CHECK(quote.succeeded && conversion.succeeded, "conversion through a converter with untracked balances failed");
+    CHECK(conversion.succeeded && quote.events("quote")[0]["return"] == conversion.events("conversion")[0]["return"],
+          "quoted return doesn't match the conversion");
+
+    // the rows are tracked again once they're written
+    for (auto reserve : { &BNT, &TKNA }) {
+        BancorConverter::reserve_t row;
+        CHECK(chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "reserves"_n, reserve->sym.code().raw(), row) &&
+              row.balance.has_value() && row.balance->amount == chain.balance(*reserve, "cnvtaa"_n), "reserve balance not tracked after a conversion");
+    }
+    chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "settings"_n, "settings"_n.value, settings);
+    CHECK(!settings.smart_supply.has_value(), "smart supply written by a reserve conversion");
+    CHECK(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNTTKNA,0.0000000001,test1").succeeded,
+          "smart token purchase from a converter with an untracked supply failed");
+    chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "settings"_n, "settings"_n.value, settings);
+    CHECK(settings.smart_supply.has_value() && settings.smart_supply->amount == chain.supply(BNTTKNA), "smart supply not tracked after a purchase");
+
+    // resync can read the rows too
+    chain.set_row("cnvtaa"_n, "cnvtaa"_n.value, "settings"_n, "settings"_n.value,
+                  legacy_settings{ settings.smart_contract, settings.smart_currency, settings.smart_enabled, settings.enabled, settings.network,
+                                   settings.require_balance, settings.max_fee, settings.fee }, "cnvtaa"_n);
+    CHECK(chain.push_action("cnvtaa"_n, "cnvtaa"_n, "resync"_n).succeeded, "resync of untracked rows failed");
+    chain.get_row("cnvtaa"_n, "cnvtaa"_n.value, "settings"_n, "settings"_n.value, settings);
+    CHECK(settings.smart_supply.has_value() && settings.smart_supply->amount == chain.supply(BNTTKNA), "smart supply not tracked after resync");
+}
+
+static void network() {
+    bancor_fixture chain;
+    chain.setup("aa"_n, "aa"_n, "issue"_n, "test1"_n, TKNA("100"), "test money");
+
+    CHECK(chain.push_action("test1"_n, "thisisbancor"_n, "regconverter"_n, "cnvtaa"_n).error == "missing authority of cnvtaa",
+          "registry updated by another account");
+    CHECK(chain.row_count("thisisbancor"_n, "thisisbancor"_n.value, "converters"_n) == 4, "unexpected registered converters");
+
+    // converters can't add themselves, and pay for the refreshes of their entry
+    chain.create_account("cnvtdd"_n);
+    chain.set_code("cnvtdd"_n, bancor_converter_apply);
+    chain.setup("cnvtdd"_n, "cnvtdd"_n, "init"_n, BNTTKNA.contract, BNTTKNA.units(0), true, true, "thisisbancor"_n, false, uint64_t(0), uint64_t(0));
+    chain.setup("cnvtdd"_n, "cnvtdd"_n, "setreserve"_n, BNT.contract, BNT.units(0), uint64_t(500), true);
+    chain.setup("cnvtdd"_n, "thisisbancor"_n, "regconverter"_n, "cnvtdd"_n);
+    CHECK(chain.row_count("thisisbancor"_n, "thisisbancor"_n.value, "converters"_n) == 4, "converter registered itself");
+
+    // an unregistered converter of the network can't forward conversions to other converters
+    chain.setup("aa"_n, "aa"_n, "issue"_n, "cnvtdd"_n, TKNA("1"), "setup");
+    CHECK(failed_with(chain.transfer(TKNA, "cnvtdd"_n, "cnvtaa"_n, TKNA("1"), "1,cnvtaa BNT,0.0000000001,cnvtdd"),
+                      "converter can only receive from network contract"), "conversion from an unregistered converter accepted");
+
+    int64_t network_ram = chain.ram_usage("thisisbancor"_n), converter_ram = chain.ram_usage("cnvtaa"_n);
+    chain.setup("cnvtaa"_n, "cnvtaa"_n, "setreserve"_n, BNT.contract, BNT.units(0), uint64_t(500), true);
+    CHECK(chain.ram_usage("thisisbancor"_n) < network_ram && chain.ram_usage("cnvtaa"_n) > converter_ram,
+          "registry refresh not billed to the converter");
+
+    // deposits have to be opened by their owner, who pays for the row
+    network_ram = chain.ram_usage("thisisbancor"_n);
+    CHECK(failed_with(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("2"), "deposit"), "deposit isn't open"),
+          "deposit without an open row accepted");
+    int64_t owner_ram = chain.ram_usage("test1"_n);
+    CHECK(chain.push_action("test1"_n, "thisisbancor"_n, "open"_n, "test1"_n, TKNA.contract, TKNA.sym).succeeded, "open failed");
+    CHECK(chain.push_action("test1"_n, "thisisbancor"_n, "open"_n, "test1"_n, TKNA.contract, TKNA.sym).succeeded, "second open failed");
+    CHECK(chain.ram_usage("test1"_n) > owner_ram, "deposit row not billed to the owner");
+    CHECK(failed_with(chain.push_action("test1"_n, "thisisbancor"_n, "open"_n, "test1"_n, "fakeaa"_n, TKNA.sym), "deposit token mismatch"),
+          "deposit reopened with another token contract");
+
+    CHECK(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("2"), "deposit").succeeded, "deposit failed");
+    CHECK(chain.ram_usage("thisisbancor"_n) == network_ram, "deposit billed to the network");
+    std::vector<conversion_item> batch = {
+        { "cnvtaa BNT", TKNA("1"), BNT.units(1), "test1"_n },
+        { "cnvtaa BNT cnvtbb TKNB", TKNA("1"), TKNB.units(1), "test1"_n }
+    };
+    auto res = chain.push_action("test1"_n, "thisisbancor"_n, "convertbatch"_n, "test1"_n, batch);
+    CHECK(res.succeeded && res.events("conversion").size() == 3, "batch conversion failed");
+    auto batch_events = res.events("batch_conversion");
+    CHECK(batch_events.size() == 1 && batch_events[0]["owner"] == "test1" && batch_events[0]["conversions"] == "2", "unexpected batch event");
+    CHECK(chain.row_count("thisisbancor"_n, "test1"_n.value, "deposits"_n) == 1, "empty deposit closed");
+
+    CHECK(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "deposit").succeeded, "deposit failed");
+    batch = { { "cnvtaa BNT", TKNA("2"), BNT.units(1), "test1"_n } };
+    CHECK(failed_with(chain.push_action("test1"_n, "thisisbancor"_n, "convertbatch"_n, "test1"_n, batch), "insufficient deposit"),
+          "batch conversion with an insufficient deposit accepted");
+    int64_t tkna = chain.balance(TKNA, "test1"_n);
+    CHECK(chain.push_action("test1"_n, "thisisbancor"_n, "withdraw"_n, "test1"_n, TKNA("1")).succeeded, "withdraw failed");
+    CHECK(chain.balance(TKNA, "test1"_n) == tkna + TKNA("1").amount, "deposit not withdrawn");
+
+    // only reserves of registered converters can be deposited
+    network_ram = chain.ram_usage("thisisbancor"_n);
+    chain.create_account("fakeaa"_n);
+    chain.set_code("fakeaa"_n, token_apply);
+    const token fake_tkna{ "fakeaa"_n, TKNA.sym };
+    chain.setup("fakeaa"_n, "fakeaa"_n, "create"_n, "fakeaa"_n, fake_tkna("1000"));
+    chain.setup("fakeaa"_n, "fakeaa"_n, "issue"_n, "test1"_n, fake_tkna("100"), "test money");
+    CHECK(failed_with(chain.transfer(fake_tkna, "test1"_n, "thisisbancor"_n, fake_tkna("1"), "deposit"), "deposit token mismatch"),
+          "deposit of a fake reserve token accepted");
+    CHECK(failed_with(chain.push_action("cnvtaa"_n, "thisisbancor"_n, "open"_n, "cnvtaa"_n, BNTTKNA.contract, BNTTKNA.sym),
+                      "deposit token is not a registered reserve"), "deposit of a non reserve token opened");
+    CHECK(failed_with(chain.transfer(BNTTKNA, "cnvtaa"_n, "thisisbancor"_n, BNTTKNA("1"), "deposit"), "deposit isn't open"),
+          "deposit of a non reserve token accepted");
+    CHECK(chain.ram_usage("thisisbancor"_n) == network_ram, "rejected deposit billed to the network");
+
+    // batch items can't be sent to BancorX, they have no memo for the target blockchain and account
+    CHECK(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("2"), "deposit").succeeded, "deposit failed");
+    batch = { { "cnvtaa BNT", TKNA("1"), BNT.units(1), "bancorxoneos"_n } };
+    CHECK(failed_with(chain.push_action("test1"_n, "thisisbancor"_n, "convertbatch"_n, "test1"_n, batch), "the destination account must be the owner"),
+          "batch conversion to BancorX accepted");
+    // the minimum return must match the return symbol precision too
+    batch = { { "cnvtaa BNT", TKNA("1"), asset(1, symbol(BNT.sym.code(), BNT.sym.precision() - 1)), "test1"_n } };
+    CHECK(failed_with(chain.push_action("test1"_n, "thisisbancor"_n, "convertbatch"_n, "test1"_n, batch), "minimum return symbol mismatch"),
+          "batch conversion with a minimum return precision mismatch accepted");
+    CHECK(chain.push_action("test1"_n, "thisisbancor"_n, "withdraw"_n, "test1"_n, TKNA("2")).succeeded, "withdraw failed");
+    CHECK(failed_with(chain.push_action("test1"_n, "thisisbancor"_n, "close"_n, "test1"_n, BNT.sym.code()), "no deposit for the token"),
+          "closed a deposit that isn't open");
+    int64_t opened_ram = chain.ram_usage("test1"_n);
+    CHECK(chain.push_action("test1"_n, "thisisbancor"_n, "close"_n, "test1"_n, TKNA.sym.code()).succeeded, "close failed");
+    CHECK(chain.row_count("thisisbancor"_n, "test1"_n.value, "deposits"_n) == 0, "deposit not closed");
+    CHECK(chain.ram_usage("test1"_n) < opened_ram, "deposit row RAM not released");
+
+    const std::string path = "cnvtaa BNT cnvtbb TKNB";
+    auto quote = chain.push_action("test1"_n, "thisisbancor"_n, "quote"_n, path, TKNA("1"));
+    auto quotes = quote.events("quote");
+    auto conversion = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1," + path + ",0.1,test1");
+    auto conversions = conversion.events("conversion");
+    CHECK(quotes.size() == 2 && conversions.size() == 2, "unexpected number of quoted steps");
+    for (size_t i = 0; i < quotes.size() && i < conversions.size(); ++i) {
+        CHECK(quotes[i]["return"] == conversions[i]["return"], "quoted return doesn't match the conversion");
+        CHECK(quotes[i]["conversion_fee"] == conversions[i]["conversion_fee"], "quoted fee doesn't match the conversion");
+    }
+}
+
+static void bancorx() {
+    bancor_fixture chain;
+
+    int64_t supply = chain.supply(BNT);
+    auto xtransfer = chain.transfer(BNT, "test1"_n, "bancorxoneos"_n, BNT("1"), "1.1,eth,0x12345123451234512345,0");
+    auto events = xtransfer.events("xtransfer");
+    CHECK(xtransfer.succeeded && events.size() == 1 && events[0]["target"] == "0x12345123451234512345", "xtransfer failed");
+    CHECK(xtransfer.events("destroy").size() == 1, "missing destroy event");
+    CHECK(chain.supply(BNT) == supply - BNT("1").amount, "xtransfer tokens not destroyed");
+
+    CHECK(failed_with(chain.transfer(BNT, "test1"_n, "bancorxoneos"_n, BNT("100000"), "1.1,eth,0x1234,0"), "overdrawn balance"),
+          "xtransfer above the balance accepted");
+    for (auto memo : { "hello", "1.1,eth", "1.1,,0x1234,0", "1.1,eth,,0", "1.1,eth,0x1234,0,extra" })
+        CHECK(failed_with(chain.transfer(BNT, "test1"_n, "bancorxoneos"_n, BNT("1"), memo), "invalid memo format"), "xtransfer without a destination accepted");
+
+    // reports
+    auto report = [&](name reporter, asset quantity, const char* data) {
+        return chain.push_action(reporter, "bancorxoneos"_n, "reporttx"_n, reporter, "eth", uint64_t(1000), uint64_t(77),
+                                 "test1"_n, quantity, "hi", data);
+    };
+
+    int64_t balance = chain.balance(BNT, "test1"_n);
+    CHECK(report("reporter1"_n, BNT("10"), "data").succeeded, "first report failed");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 1, "report not recorded");
+    CHECK(chain.balance(BNT, "test1"_n) == balance, "tokens issued after a single report");
+
+    // reporters 1-3 were added in order and hold the indexes 0-2
+    BancorX::transfer_t pending;
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, 1000, pending) &&
+          pending.reporters == 1 && pending.reporters_count == 1, "unexpected reporters mask");
+
+    // the pending transfer only keeps the hash of the reported payload
+    auto packed = eosio::pack(BancorX::transfer_report{ "eth", 1000, 77, "test1"_n, BNT("10"), "hi", "data" });
+    CHECK(pending.payload_hash == eosio::sha256(packed.data(), packed.size()), "unexpected payload hash");
+
+    CHECK(failed_with(report("reporter1"_n, BNT("10"), "data"), "the reporter already reported the transfer"), "duplicate report accepted");
+    CHECK(failed_with(report("reporter4"_n, BNT("10"), "data"), "the signer is not a known reporter"), "non reporter accepted");
+    CHECK(failed_with(report("reporter2"_n, BNT("10"), "other"), "transfer data doesn't match"), "conflicting report accepted");
+    CHECK(failed_with(chain.push_action("reporter2"_n, "bancorxoneos"_n, "reporttx"_n, "reporter2"_n, "eth", uint64_t(1000), uint64_t(77),
+                                        "test1"_n, BNT("10"), "bye", "data"), "transfer data doesn't match"), "report with a different memo accepted");
+
+    auto issue = report("reporter2"_n, BNT("10"), "data");
+    CHECK(issue.succeeded && issue.events("xtransfercomplete").size() == 1, "second report failed");
+    CHECK(chain.balance(BNT, "test1"_n) == balance + BNT("10").amount, "tokens not issued after 2/2 reports");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 0, "completed transfer not erased");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n) == 1, "amount not recorded");
+
+    // transfer by id
+    CHECK(chain.push_action("reporter2"_n, "bnt"_n, "transferbyid"_n, "test1"_n, "reporter1"_n, "bancorxoneos"_n, uint64_t(77), "hi").error ==
+          "missing authority of test1", "transfer by id with the wrong authority accepted");
+    int64_t reporter1 = chain.balance(BNT, "reporter1"_n);
+    CHECK(chain.push_action("test1"_n, "bnt"_n, "transferbyid"_n, "test1"_n, "reporter1"_n, "bancorxoneos"_n, uint64_t(77), "hi").succeeded,
+          "transfer by id failed");
+    CHECK(chain.balance(BNT, "reporter1"_n) == reporter1 + BNT("10").amount, "transfer by id amount not transferred");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n) == 0, "amount not cleared");
+
+    // a single report signed by several reporters
+    auto report_multi = [&](std::vector<name> signers, std::vector<name> reporters, uint64_t tx_id) {
+        std::vector<eosio::permission_level> auths;
+        for (auto signer : signers)
+            auths.emplace_back(signer, "active"_n);
+        return chain.push_transaction({ eosio::action(auths, "bancorxoneos"_n, "reportmulti"_n,
+            std::make_tuple(reporters, std::string("eth"), tx_id, uint64_t(0), "test1"_n, BNT("5"), std::string("hi"), std::string("data"))) });
+    };
+
+    CHECK(report_multi({ "reporter1"_n }, { "reporter1"_n, "reporter2"_n }, 1001).error == "missing authority of reporter2",
+          "multi reporter report without all the signatures accepted");
+    CHECK(failed_with(report_multi({ "reporter1"_n }, { "reporter1"_n, "reporter1"_n }, 1001), "duplicate reporter"), "duplicate reporter accepted");
+    CHECK(failed_with(report_multi({ "reporter1"_n, "reporter4"_n }, { "reporter1"_n, "reporter4"_n }, 1001), "the signer is not a known reporter"),
+          "multi reporter report by a non reporter accepted");
+
+    balance = chain.balance(BNT, "test1"_n);
+    auto multi = report_multi({ "reporter1"_n, "reporter2"_n }, { "reporter1"_n, "reporter2"_n }, 1001);
+    CHECK(multi.succeeded && multi.events("txreport").size() == 2, "multi reporter report failed");
+    CHECK(chain.balance(BNT, "test1"_n) == balance + BNT("5").amount, "tokens not issued after a multi reporter report");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 0, "completed transfer not erased");
+
+    // a multi reporter report completes a transfer reported by a single reporter
+    CHECK(report_multi({ "reporter3"_n }, { "reporter3"_n }, 1002).succeeded, "single reporter report failed");
+    CHECK(failed_with(report_multi({ "reporter1"_n, "reporter3"_n }, { "reporter1"_n, "reporter3"_n }, 1002), "the reporter already reported the transfer"),
+          "duplicate report in a multi reporter report accepted");
+    CHECK(report_multi({ "reporter1"_n }, { "reporter1"_n }, 1002).events("xtransfercomplete").size() == 1, "transfer not completed");
+
+    // batched reports by a single reporter
+    using transfer_report = std::tuple<std::string, uint64_t, uint64_t, name, asset, std::string, std::string>;
+    auto report_batch = [&](name reporter, std::vector<uint64_t> tx_ids, asset quantity) {
+        std::vector<transfer_report> reports;
+        for (auto tx_id : tx_ids)
+            reports.emplace_back("eth", tx_id, 0, "test1"_n, quantity, "hi", "data");
+        return chain.push_action(reporter, "bancorxoneos"_n, "reportbatch"_n, reporter, reports);
+    };
+
+    CHECK(failed_with(report_batch("reporter1"_n, {}, BNT("1")), "empty report batch"), "empty report batch accepted");
+    CHECK(failed_with(report_batch("reporter1"_n, { 2001, 2001 }, BNT("1")), "the reporter already reported the transfer"),
+          "duplicate report in a batch accepted");
+
+    // every new transfer of the batch counts towards the same issue limit
+    CHECK(failed_with(report_batch("reporter1"_n, { 2001, 2002 }, BNT("600000")), "above max limit"), "batch above the issue limit accepted");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 0, "failed batch not rolled back");
+
+    balance = chain.balance(BNT, "test1"_n);
+    auto batch = report_batch("reporter1"_n, { 2001, 2002 }, BNT("3"));
+    CHECK(batch.succeeded && batch.events("txreport").size() == 2, "report batch failed");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 2, "batched reports not recorded");
+    batch = report_batch("reporter2"_n, { 2001, 2002 }, BNT("3"));
+    CHECK(batch.succeeded && batch.events("xtransfercomplete").size() == 2, "batched transfers not completed");
+    CHECK(chain.balance(BNT, "test1"_n) == balance + BNT("6").amount, "tokens not issued after 2/2 batched reports");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 0, "completed transfers not erased");
+
+    // a removed reporter's reports stop counting and its index isn't reused while they're pending
+    auto set_min_reporters = [&](uint64_t min_reporters) {
+        chain.setup("bancorxoneos"_n, "bancorxoneos"_n, "update"_n, min_reporters, uint64_t(1), uint64_t(100000000000000),
+                    uint64_t(10000000000000000), uint64_t(10000000000000000));
+    };
+    set_min_reporters(3);
+    balance = chain.balance(BNT, "test1"_n);
+    CHECK(report_batch("reporter1"_n, { 3001 }, BNT("1")).succeeded && report_batch("reporter2"_n, { 3001, 3002 }, BNT("1")).succeeded,
+          "reports before the reporter removal failed");
+    chain.setup("bancorxoneos"_n, "bancorxoneos"_n, "rmreporter"_n, "reporter2"_n);
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n) == 2 &&
+          chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "retired"_n) == 1, "reporter removal touched the pending transfers");
+
+    BancorX::reporter_t reporter;
+    chain.setup("bancorxoneos"_n, "bancorxoneos"_n, "addreporter"_n, "reporter4"_n);
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "reporters"_n, "reporter4"_n.value, reporter) && reporter.index == 3,
+          "removed reporter's index reused while its reports are pending");
+    chain.setup("bancorxoneos"_n, "bancorxoneos"_n, "addreporter"_n, "reporter2"_n);
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "reporters"_n, "reporter2"_n.value, reporter) && reporter.index == 4,
+          "re-added reporter got its old index");
+    auto again = report_batch("reporter2"_n, { 3001 }, BNT("1"));
+    CHECK(again.succeeded && again.events("xtransfercomplete").empty(), "re-added reporter counted twice");
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, 3001, pending) &&
+          pending.reporters == (1 | 1 << 4) && pending.reporters_count == 2, "removed reporter's report not dropped");
+    CHECK(report_batch("reporter4"_n, { 3001 }, BNT("1")).events("xtransfercomplete").size() == 1, "transfer not completed by 3 reporters");
+    CHECK(chain.balance(BNT, "test1"_n) == balance + BNT("1").amount, "tokens not issued after 3/3 reports");
+
+    // the index is free again once the transfers the removed reporter could have reported expired
+    chain.produce_blocks(TRANSFER_EXPIRATION * 2);
+    chain.create_account("reporter5"_n);
+    chain.setup("bancorxoneos"_n, "bancorxoneos"_n, "addreporter"_n, "reporter5"_n);
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "reporters"_n, "reporter5"_n.value, reporter) && reporter.index == 1,
+          "expired reporter index not reused");
+    CHECK(chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "retired"_n) == 0, "expired retired index not erased");
+    CHECK(report_batch("reporter5"_n, { 3002 }, BNT("1")).succeeded, "report with a reused index failed");
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, 3002, pending) &&
+          pending.reporters == 1 << 1 && pending.reporters_count == 1, "expired transfer not reported from scratch");
+    set_min_reporters(2);
+
+    // up to MAX_REPORTERS reporters, indexes 0-4 are taken
+    for (int i = 5; i < MAX_REPORTERS; ++i) {
+        name account(std::string("rptr") + char('a' + i / 26) + char('a' + i % 26));
+        chain.create_account(account);
+        chain.setup("bancorxoneos"_n, "bancorxoneos"_n, "addreporter"_n, account);
+    }
+    CHECK(failed_with(chain.push_action("bancorxoneos"_n, "bancorxoneos"_n, "addreporter"_n, "test2"_n), "too many reporters"),
+          "reporter above MAX_REPORTERS accepted");
+
+    // convert and xtransfer in one action
+    chain.setup("aa"_n, "aa"_n, "issue"_n, "test1"_n, TKNA("5"), "test money");
+    auto convert = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("5"),
+                                  "1,cnvtaa BNT,1.0000000000,bancorxoneos;1.1,eth,0x12345123451234512345,1234");
+    events = convert.events("xtransfer");
+    CHECK(convert.succeeded && events.size() == 1 && events[0]["id"] == "1234" && events[0]["blockchain"] == "eth",
+          "convert and xtransfer failed");
+}
+
+// expired transfers and amounts are removed a few at a time by reports and x transfers, or by purge
+static void expiration() {
+    bancor_fixture chain;
+
+    auto report = [&](name reporter, uint64_t tx_id, uint64_t x_transfer_id) {
+        return chain.push_action(reporter, "bancorxoneos"_n, "reporttx"_n, reporter, "eth", tx_id, x_transfer_id,
+                                 "test1"_n, BNT("1"), "hi", "data");
+    };
+    auto transfers = [&]() { return chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n); };
+    auto amounts = [&]() { return chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n); };
+    auto seconds = [&](uint64_t count) { chain.produce_blocks(count * 2); };
+
+    CHECK(report("reporter1"_n, 3001, 0).succeeded, "report failed");
+    CHECK(report("reporter1"_n, 3002, 88).succeeded && report("reporter2"_n, 3002, 88).succeeded, "transfer not completed");
+    CHECK(transfers() == 1 && amounts() == 1, "unexpected rows");
+
+    seconds(TRANSFER_EXPIRATION - 1);
+    chain.setup("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(10));
+    CHECK(transfers() == 1 && amounts() == 1, "rows purged before they expired");
+
+    // the next report removes the expired transfer
+    seconds(1);
+    CHECK(report("reporter1"_n, 3003, 0).succeeded, "report failed");
+    CHECK(transfers() == 1, "expired transfer not purged");
+
+    // a late report of an expired transfer starts it over
+    CHECK(report("reporter2"_n, 3001, 0).succeeded && transfers() == 2, "late report not recorded as a new transfer");
+
+    // every x transfer removes at most PURGE_STEP expired rows of each table
+    for (uint64_t tx_id = 3004; tx_id < 3009; ++tx_id)
+        report("reporter1"_n, tx_id, 0);
+    seconds(AMOUNT_EXPIRATION);
+    CHECK(chain.transfer(BNT, "test1"_n, "bancorxoneos"_n, BNT("1"), "1.1,eth,0x1234,0").succeeded, "xtransfer failed");
+    CHECK(transfers() == 7 - PURGE_STEP && amounts() == 0, "unexpected number of purged rows");
+
+    CHECK(failed_with(chain.push_action("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(0)), "max rows must be positive"), "empty purge accepted");
+    chain.setup("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(3));
+    CHECK(transfers() == 7 - PURGE_STEP - 3, "purge removed more than max rows");
+    chain.setup("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(100));
+    CHECK(transfers() == 0 && amounts() == 0, "expired rows not purged");
+}
+
+// BancorX rows stored before the report / issue time was tracked
+struct legacy_transfer {
+    uint64_t    tx_id;
+    checksum256 payload_hash;
+    uint64_t    reporters;
+    uint8_t     reporters_count;
+};
+
+struct legacy_amount {
+    uint64_t x_transfer_id;
+    name     target;
+    asset    quantity;
+};
+
+// legacy rows have no entries in the time indexes, they're treated as expired until they're migrated
+static void legacy_bancorx() {
+    bancor_fixture chain;
+
+    auto report = [&](name reporter, uint64_t tx_id, uint64_t x_transfer_id) {
+        return chain.push_action(reporter, "bancorxoneos"_n, "reporttx"_n, reporter, "eth", tx_id, x_transfer_id,
+                                 "test1"_n, BNT("1"), "hi", "data");
+    };
+    auto transfers = [&]() { return chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n); };
+    auto amounts = [&]() { return chain.row_count("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n); };
+
+    BancorX::transfer_t pending;
+    for (uint64_t tx_id : { 4001, 4002 }) {
+        CHECK(report("reporter1"_n, tx_id, 0).succeeded, "report failed");
+        chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, tx_id, pending);
+        chain.set_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, tx_id,
+                      legacy_transfer{ pending.tx_id, pending.payload_hash, pending.reporters, pending.reporters_count }, "bancorxoneos"_n);
+    }
+    for (uint64_t x_transfer_id : { 91, 92, 93 })
+        chain.set_row("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n, x_transfer_id,
+                      legacy_amount{ x_transfer_id, "test1"_n, BNT("1") }, "bancorxoneos"_n);
+
+    BancorX::amounts_t amount;
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n, 91, amount) && !amount.issue_time.has_value(),
+          "legacy amount read with an issue time");
+
+    // transferbyid clears a legacy amount with an inline clearamount
+    int64_t balance = chain.balance(BNT, "reporter1"_n);
+    CHECK(chain.push_action("test1"_n, "bnt"_n, "transferbyid"_n, "test1"_n, "reporter1"_n, "bancorxoneos"_n, uint64_t(91), "hi").succeeded,
+          "transferbyid of a legacy amount failed");
+    CHECK(chain.balance(BNT, "reporter1"_n) == balance + BNT("1").amount && amounts() == 2, "legacy amount not cleared");
+
+    // purge walks the time indexes, which have no entries for legacy rows
+    chain.setup("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(100));
+    CHECK(transfers() == 2 && amounts() == 2, "legacy rows purged");
+
+    // a report of a legacy transfer starts it over
+    auto restart = report("reporter2"_n, 4001, 0);
+    CHECK(restart.succeeded && restart.events("xtransfercomplete").empty(), "legacy transfer completed by its old reports");
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, 4001, pending) && pending.report_time.has_value() &&
+          pending.reporters_count == 1, "legacy transfer not reported from scratch");
+
+    CHECK(chain.push_action("test1"_n, "bancorxoneos"_n, "migrate"_n, std::vector<uint64_t>{ 4002 }, std::vector<uint64_t>{}).error ==
+          "missing authority of bancorxoneos", "migrate by another account accepted");
+    CHECK(failed_with(chain.push_action("bancorxoneos"_n, "bancorxoneos"_n, "migrate"_n, std::vector<uint64_t>{ 4003 }, std::vector<uint64_t>{}),
+                      "transfer doesn't exist in table"), "migration of a missing transfer accepted");
+    CHECK(chain.push_action("bancorxoneos"_n, "bancorxoneos"_n, "migrate"_n, std::vector<uint64_t>{ 4001, 4002 },
+                            std::vector<uint64_t>{ 92, 93 }).succeeded, "migrate failed");
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "amounts"_n, 92, amount) && amount.issue_time.has_value() &&
+          amount.target == "test1"_n && amount.quantity == BNT("1"), "legacy amount not migrated");
+    CHECK(chain.get_row("bancorxoneos"_n, "bancorxoneos"_n.value, "transfers"_n, 4002, pending) && pending.report_time.has_value() &&
+          pending.reporters == 1 && pending.reporters_count == 1, "legacy transfer not migrated");
+
+    // migrated rows expire like the other rows
+    chain.setup("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(100));
+    CHECK(transfers() == 2 && amounts() == 2, "migrated rows purged before they expired");
+    chain.produce_blocks(AMOUNT_EXPIRATION * 2);
+    chain.setup("test1"_n, "bancorxoneos"_n, "purge"_n, uint32_t(100));
+    CHECK(transfers() == 0 && amounts() == 0, "migrated rows not purged");
+}
+
+static void rerouter() {
+    bancor_fixture chain;
+
+    CHECK(!chain.push_action("test1"_n, "txrerouter"_n, "reroutetx"_n, uint64_t(1), "eth", "0x1234").succeeded, "reroute before enabling accepted");
+    CHECK(chain.push_action("test1"_n, "txrerouter"_n, "enablerrt"_n, true).error == "missing authority of txrerouter", "enablerrt by another account accepted");
+
+    CHECK(chain.push_action("txrerouter"_n, "txrerouter"_n, "enablerrt"_n, true).succeeded, "enablerrt failed");
+    auto res = chain.push_action("test1"_n, "txrerouter"_n, "reroutetx"_n, uint64_t(1), "eth", "0x1234");
+    auto events = res.events("txreroute");
+    CHECK(res.succeeded && events.size() == 1 && events[0]["tx_id"] == "1" && events[0]["target"] == "0x1234", "reroute failed");
+
+    CHECK(chain.push_action("txrerouter"_n, "txrerouter"_n, "enablerrt"_n, false).succeeded, "enablerrt failed");
+    CHECK(failed_with(chain.push_action("test1"_n, "txrerouter"_n, "reroutetx"_n, uint64_t(1), "eth", "0x1234"), "transaction rerouting is disabled"),
+          "reroute after disabling accepted");
+}
+
+// every step of a conversion path is an inline action one level deeper than the previous step
+static void inline_depth() {
+    bancor_fixture chain;
+    chain.setup("aa"_n, "aa"_n, "issue"_n, "test1"_n, TKNA("10"), "test money");
+
+    // the final transfer of a 2 hop conversion is 3 levels deep, buying a smart token issues it 4 levels deep
+    auto res = chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNT cnvtbb BNTTKNB,0.1,test1");
+    uint32_t depth = 0;
+    for (auto& trace : res.traces)
+        depth = std::max(depth, trace.depth);
+    CHECK(res.succeeded && depth == 4, "unexpected inline action depth");
+
+    chain.max_inline_action_depth = 3;
+    uint64_t digest = chain.state_digest();
+    CHECK(failed_with(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNT cnvtbb BNTTKNB,0.1,test1"),
+                      "max inline action depth per transaction reached"), "inline depth limit not enforced");
+    CHECK(chain.state_digest() == digest, "the transaction above the depth limit changed the tables");
+    CHECK(chain.transfer(TKNA, "test1"_n, "thisisbancor"_n, TKNA("1"), "1,cnvtaa BNT cnvtbb TKNB,0.1,test1").succeeded,
+          "conversion within the depth limit failed");
+}
+
+struct converter_info {
+    name         account;
+    const token* reserves[2];
+    const token* smart;
+    bool         smart_enabled;
+};
+
+static const converter_info CONVERTERS[] = {
+    { "bnt2eoscnvrt"_n, { &BNT, &SYS }, &BNTEOS, false },
+    { "cnvtaa"_n, { &BNT, &TKNA }, &BNTTKNA, true },
+    { "cnvtbb"_n, { &BNT, &TKNB }, &BNTTKNB, true },
+    { "cnvtcc"_n, { &BNT, &TKNC }, &BNTTKNC, true }
+};
+
+static const token* const TOKENS[] = { &BNT, &SYS, &BNTEOS, &TKNA, &TKNB, &TKNC, &BNTTKNA, &BNTTKNB, &BNTTKNC };
+
+struct path_step {
+    const converter_info* converter;
+    const token*          to;
+};
+
+// a random 1 or 2 step path from the given token, empty if there isn't one
+static std::vector<path_step> random_path(std::mt19937_64& rng, const token* from) {
+    std::vector<path_step> path;
+    const converter_info* previous = nullptr;
+    for (int step = 0; step < 2; ++step) {
+        std::vector<path_step> options;
+        for (auto& c : CONVERTERS) {
+            if (&c == previous)
+                continue;
+            bool has_from = c.smart == from || c.reserves[0] == from || c.reserves[1] == from;
+            if (!has_from)
+                continue;
+            for (auto to : { c.reserves[0], c.reserves[1], c.smart })
+                if (to != from && (to != c.smart || c.smart_enabled))
+                    options.push_back({ &c, to });
+        }
+        if (options.empty())
+            break;
+
+        path.push_back(options[rng() % options.size()]);
+        previous = path.back().converter;
+        from = path.back().to;
+        // smart tokens can only be the final step
+        if (from == previous->smart || rng() % 2)
+            break;
+    }
+    return path;
+}
+
+static void check_invariants(bancor_fixture& chain) {
+    for (auto t : TOKENS)
+        CHECK(chain.total_balance(t->contract, t->sym.code()) == chain.supply(*t), "balances don't add up to the supply");
+
+    for (auto& c : CONVERTERS) {
+        BancorConverter::settings_t settings;
+        chain.get_row(c.account, c.account.value, "settings"_n, "settings"_n.value, settings);
+        CHECK(settings.smart_supply.has_value() && settings.smart_supply->amount == chain.supply(*c.smart), "tracked smart supply doesn't match the token");
+
+        for (auto reserve : c.reserves) {
+            BancorConverter::reserve_t row;
+            chain.get_row(c.account, c.account.value, "reserves"_n, reserve->sym.code().raw(), row);
+            CHECK(row.balance.has_value() && row.balance->amount == chain.balance(*reserve, c.account), "tracked reserve balance doesn't match the token");
+        }
+    }
+}
+
+static void properties(uint64_t seed, uint32_t count) {
+    bancor_fixture chain;
+    for (auto t : { &TKNA, &TKNB, &TKNC })
+        chain.setup(t->contract, t->contract, "issue"_n, "test1"_n, (*t)("10000"), "test money");
+
+    std::mt19937_64 rng(seed);
+    uint32_t converted = 0, rejected = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < count && failures == 0; ++i) {
+        std::vector<const token*> held;
+        for (auto t : TOKENS)
+            if (chain.balance(*t, "test1"_n) >= 1000)
+                held.push_back(t);
+        const token* from = held[rng() % held.size()];
+
+        auto path = random_path(rng, from);
+        if (path.empty())
+            continue;
+        std::string path_str;
+        for (auto& step : path)
+            path_str += (path_str.empty() ? "" : " ") + step.converter->account.to_string() + " " + step.to->sym.code().to_string();
+        const token* to = path.back().to;
+
+        // up to 1% of the balance
+        int64_t balance = chain.balance(*from, "test1"_n);
+        asset quantity = from->units(1 + rng() % (balance / 100));
+
+        auto quote = chain.push_action("test1"_n, "thisisbancor"_n, "quote"_n, path_str, quantity);
+        auto quotes = quote.events("quote");
+        CHECK(quote.succeeded && quotes.size() == path.size(), "quote failed");
+        if (!quote.succeeded)
+            break;
+        int64_t quoted = (*to)(quotes.back()["return"].c_str()).amount;
+
+        // every 8th conversion requires more than the quoted return and has to fail
+        bool reject = rng() % 8 == 0;
+        asset min_return = to->units(reject ? quoted + 1 : std::max<int64_t>(quoted / 2, 1));
+        std::string memo;
+        switch (rng() % 3) {
+            case 0: memo = "1," + path_str + "," + decimal(min_return) + ",test1"; break;
+            case 1: memo = "1.1,0," + path_str + "," + decimal(min_return) + ",test1"; break;
+            default: memo = packed_memo(path_str, min_return.amount, "test1"_n); break;
+        }
+
+        uint64_t digest = chain.state_digest();
+        int64_t to_balance = chain.balance(*to, "test1"_n);
+        auto res = chain.transfer(*from, "test1"_n, "thisisbancor"_n, quantity, memo);
+
+        if (reject) {
+            CHECK(failed_with(res, "below min return"), "conversion below the min return accepted");
+            CHECK(chain.state_digest() == digest, "failed conversion changed the tables");
+            ++rejected;
+            continue;
+        }
+
+        CHECK(res.succeeded, "conversion failed");
+        if (!res.succeeded) {
+            printf("%s %s: %s\n", memo.c_str(), decimal(quantity).c_str(), res.error.c_str());
+            break;
+        }
+        CHECK(res.events("conversion").size() == path.size(), "unexpected number of conversions");
+        CHECK(chain.balance(*from, "test1"_n) == balance - quantity.amount, "unexpected 'from' balance");
+        CHECK(chain.balance(*to, "test1"_n) == to_balance + quoted, "return doesn't match the quote");
+        ++converted;
+
+        if (converted % 64 == 0)
+            check_invariants(chain);
+    }
+    check_invariants(chain);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("seed %llu: %u conversions, %u rejected, %.0f conversions/s (with quotes and checks)\n",
+           (unsigned long long)seed, converted, rejected, (converted + rejected) / seconds);
+    CHECK(converted > count / 2, "too few conversions");
+}
+
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode != "--scenarios" && mode != "--properties") {
+        printf("usage: sim_test --scenarios | --properties [seed] [conversions]\n");
+        return 1;
+    }
+
+    try {
+        if (mode == "--scenarios") {
+            conversions();
+            legacy_converter();
+            network();
+            bancorx();
+            rerouter();
+            expiration();
+            legacy_bancorx();
+            inline_depth();
+        }
+        else
+            properties(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1, argc > 3 ? std::atoi(argv[3]) : 2000);
+    }
+    catch (const std::exception& e) {
+        printf("FAILED: %s\n", e.what());
+        return 1;
+    }
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
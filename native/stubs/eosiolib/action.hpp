@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "datastream.hpp"
+
+// copies the data of the executing action into msg, returns the number of bytes copied
+inline uint32_t read_action_data(void* msg, uint32_t len) {
+    const auto& data = eosio::native::current_host().action_data();
+    uint32_t size = std::min<size_t>(len, data.size());
+    memcpy(msg, data.data(), size);
+    return size;
+}
+
+inline uint32_t action_data_size() {
+    return eosio::native::current_host().action_data().size();
+}
+
+namespace eosio {
+
+struct permission_level {
+    permission_level(name a, name p) : actor(a), permission(p) {}
+    permission_level() = default;
+
+    name actor;
+    name permission;
+
+    friend bool operator==(const permission_level& a, const permission_level& b) { return a.actor == b.actor && a.permission == b.permission; }
+    EOSLIB_SERIALIZE(permission_level, (actor)(permission))
+};
+
+inline name current_receiver() {
+    return name(native::current_host().current_receiver());
+}
+
+inline bool has_auth(name n) {
+    return native::current_host().has_auth(n.value);
+}
+
+// fails with the same message as nodeos
+inline void require_auth(name n) {
+    if (!has_auth(n))
+        throw std::runtime_error("missing authority of " + n.to_string());
+}
+
+inline void require_auth(const permission_level& level) {
+    require_auth(level.actor);
+}
+
+inline bool is_account(name n) {
+    return native::current_host().is_account(n.value);
+}
+
+inline void require_recipient(name notify_account) {
+    native::current_host().require_recipient(notify_account.value);
+}
+
+template<typename... Accounts>
+void require_recipient(name notify_account, Accounts... remaining_accounts) {
+    require_recipient(notify_account);
+    require_recipient(remaining_accounts...);
+}
+
+struct action {
+    eosio::name                   account;
+    eosio::name                   name;
+    std::vector<permission_level> authorization;
+    std::vector<char>             data;
+
+    action() = default;
+
+    template<typename T>
+    action(const permission_level& auth, eosio::name a, eosio::name n, T&& value)
+        : account(a), name(n), authorization(1, auth), data(pack(std::forward<T>(value))) {}
+
+    template<typename T>
+    action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T&& value)
+        : account(a), name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value))) {}
+
+    // queues the action, it runs after the sending action and its notifications
+    void send() const {
+        native::current_host().send_inline(*this);
+    }
+
+    template<typename T>
+    T data_as() const {
+        return unpack<T>(data);
+    }
+};
+
+template<typename T>
+T unpack_action_data() {
+    return unpack<T>(native::current_host().action_data());
+}
+
+template<typename, name::raw>
+struct inline_dispatcher;
+
+template<typename T, name::raw Name, typename... Args>
+struct inline_dispatcher<void(T::*)(Args...), Name> {
+    static void call(eosio::name code, const permission_level& perm, std::tuple<std::decay_t<Args>...> args) {
+        action(perm, code, eosio::name(Name), std::move(args)).send();
+    }
+
+    static void call(eosio::name code, std::vector<permission_level> perms, std::tuple<std::decay_t<Args>...> args) {
+        action(std::move(perms), code, eosio::name(Name), std::move(args)).send();
+    }
+};
+
+}
+
+#define INLINE_ACTION_SENDER(CONTRACT_CLASS, NAME) \
+    ::eosio::inline_dispatcher<decltype(&CONTRACT_CLASS::NAME), eosio::name(#NAME)>::call
+
+#define SEND_INLINE_ACTION(CONTRACT, NAME, ...) \
+    INLINE_ACTION_SENDER(std::decay_t<decltype(CONTRACT)>, NAME)((CONTRACT).get_self(), __VA_ARGS__)
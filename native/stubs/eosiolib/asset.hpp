@@ -0,0 +1,44 @@
+#pragma once
+
+#include "symbol.hpp"
+
+namespace eosio {
+
+struct asset {
+    static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+    int64_t       amount = 0;
+    eosio::symbol symbol;
+
+    asset() = default;
+    asset(int64_t a, eosio::symbol s) : amount(a), symbol(s) {
+        eosio_assert(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+        eosio_assert(symbol.is_valid(), "invalid symbol name");
+    }
+
+    bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+    bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+    asset operator-() const { return asset(-amount, symbol); }
+
+    asset& operator+=(const asset& a) {
+        eosio_assert(a.symbol == symbol, "attempt to add asset with different symbol");
+        amount += a.amount;
+        eosio_assert(is_amount_within_range(), "addition overflow");
+        return *this;
+    }
+
+    asset& operator-=(const asset& a) {
+        eosio_assert(a.symbol == symbol, "attempt to subtract asset with different symbol");
+        amount -= a.amount;
+        eosio_assert(is_amount_within_range(), "subtraction underflow");
+        return *this;
+    }
+
+    friend asset operator+(const asset& a, const asset& b) { asset res = a; return res += b; }
+    friend asset operator-(const asset& a, const asset& b) { asset res = a; return res -= b; }
+    friend bool operator==(const asset& a, const asset& b) { return a.symbol == b.symbol && a.amount == b.amount; }
+    friend bool operator!=(const asset& a, const asset& b) { return !(a == b); }
+};
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <utility>
+
+#include "system.h"
+
+namespace eosio {
+
+// a trailing field added to a struct after rows or actions were serialized without it
+// like eosio.cdt, it's only read if the data has bytes left and always written, as the default value if empty
+template<typename T>
+class binary_extension {
+    public:
+        binary_extension() = default;
+        binary_extension(const T& value) : _has_value(true), _value(value) {}
+        binary_extension(T&& value) : _has_value(true), _value(std::move(value)) {}
+
+        bool has_value() const { return _has_value; }
+        explicit operator bool() const { return _has_value; }
+
+        T& value() {
+            eosio_assert(_has_value, "cannot get value of empty binary_extension");
+            return _value;
+        }
+
+        const T& value() const {
+            eosio_assert(_has_value, "cannot get value of empty binary_extension");
+            return _value;
+        }
+
+        T value_or() const { return _has_value ? _value : T(); }
+
+        template<typename U>
+        T value_or(U&& def) const { return _has_value ? _value : static_cast<T>(std::forward<U>(def)); }
+
+        T& operator*() { return value(); }
+        const T& operator*() const { return value(); }
+        T* operator->() { return &value(); }
+        const T* operator->() const { return &value(); }
+
+        template<typename... Args>
+        T& emplace(Args&&... args) {
+            _value = T(std::forward<Args>(args)...);
+            _has_value = true;
+            return _value;
+        }
+
+        void reset() {
+            _value = T();
+            _has_value = false;
+        }
+
+    private:
+        bool _has_value = false;
+        T    _value{};
+};
+
+template<typename DataStream, typename T>
+DataStream& operator<<(DataStream& ds, const binary_extension<T>& value) {
+    return ds << value.value_or();
+}
+
+template<typename DataStream, typename T>
+DataStream& operator>>(DataStream& ds, binary_extension<T>& value) {
+    if (ds.remaining()) {
+        T res;
+        ds >> res;
+        value.emplace(std::move(res));
+    }
+    return ds;
+}
+
+}
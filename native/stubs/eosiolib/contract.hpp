@@ -0,0 +1,25 @@
+#pragma once
+
+#include "datastream.hpp"
+
+#define CONTRACT class
+#define ACTION void
+#define TABLE struct
+
+namespace eosio {
+
+class contract {
+    public:
+        contract(name receiver, name code, datastream<const char*> ds) : _self(receiver), _code(code), _ds(ds) {}
+
+        name get_self() const { return _self; }
+        name get_code() const { return _code; }
+        datastream<const char*>& get_datastream() { return _ds; }
+
+    protected:
+        name _self;                     // the account the contract is deployed to
+        name _code;                     // the account the action was sent to, differs from _self for notifications
+        datastream<const char*> _ds;
+};
+
+}
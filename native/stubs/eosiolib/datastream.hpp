@@ -0,0 +1,333 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "system.h"
+#include "name.hpp"
+#include "symbol.hpp"
+#include "asset.hpp"
+
+namespace eosio {
+
+// reads and writes the eosio binary format, the same encoding nodeos uses for action data and table rows
+template<typename T>
+class datastream {
+    public:
+        datastream(T start, size_t size) : _start(start), _pos(start), _end(start + size) {}
+
+        void skip(size_t size) {
+            eosio_assert(size <= remaining(), "datastream attempted to read past the end");
+            _pos += size;
+        }
+
+        bool read(char* data, size_t size) {
+            eosio_assert(size <= remaining(), "datastream attempted to read past the end");
+            memcpy(data, _pos, size);
+            _pos += size;
+            return true;
+        }
+
+        bool write(const char* data, size_t size) {
+            eosio_assert(size <= remaining(), "datastream attempted to write past the end");
+            memcpy(const_cast<char*>(_pos), data, size);
+            _pos += size;
+            return true;
+        }
+
+        T pos() const { return _pos; }
+        size_t tellp() const { return size_t(_pos - _start); }
+        size_t remaining() const { return size_t(_end - _pos); }
+
+    private:
+        T _start;
+        T _pos;
+        T _end;
+};
+
+// counts the size of the serialized data
+template<>
+class datastream<size_t> {
+    public:
+        datastream(size_t init = 0) : _size(init) {}
+
+        bool skip(size_t size) { _size += size; return true; }
+        bool write(const char*, size_t size) { _size += size; return true; }
+        size_t tellp() const { return _size; }
+
+    private:
+        size_t _size;
+};
+
+namespace native {
+
+// aggregate reflection, table rows declared without EOSLIB_SERIALIZE are serialized field by field
+// like eosio.cdt does, up to 16 fields
+struct any_field {
+    template<typename U>
+    operator U() const;
+};
+
+template<typename T, typename Seq, typename = void>
+struct brace_constructible : std::false_type {};
+
+template<typename T, size_t... I>
+struct brace_constructible<T, std::index_sequence<I...>, std::void_t<decltype(T{ (void(I), any_field{})... })>> : std::true_type {};
+
+template<typename T, size_t N = 16>
+constexpr size_t field_count() {
+    if constexpr (N == 0)
+        return 0;
+    else if constexpr (brace_constructible<T, std::make_index_sequence<N>>::value)
+        return N;
+    else
+        return field_count<T, N - 1>();
+}
+
+// calls f with every field of an aggregate, in declaration order
+template<typename T, typename F>
+void for_each_field(T& t, F&& f) {
+    constexpr size_t n = field_count<std::remove_const_t<T>>();
+    static_assert(n <= 16, "aggregates with more than 16 fields need EOSLIB_SERIALIZE");
+    if constexpr (n == 1) { auto& [a] = t; f(a); }
+    else if constexpr (n == 2) { auto& [a, b] = t; f(a); f(b); }
+    else if constexpr (n == 3) { auto& [a, b, c] = t; f(a); f(b); f(c); }
+    else if constexpr (n == 4) { auto& [a, b, c, d] = t; f(a); f(b); f(c); f(d); }
+    else if constexpr (n == 5) { auto& [a, b, c, d, e] = t; f(a); f(b); f(c); f(d); f(e); }
+    else if constexpr (n == 6) { auto& [a, b, c, d, e, g] = t; f(a); f(b); f(c); f(d); f(e); f(g); }
+    else if constexpr (n == 7) { auto& [a, b, c, d, e, g, h] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); }
+    else if constexpr (n == 8) { auto& [a, b, c, d, e, g, h, i] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); }
+    else if constexpr (n == 9) { auto& [a, b, c, d, e, g, h, i, j] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); }
+    else if constexpr (n == 10) { auto& [a, b, c, d, e, g, h, i, j, k] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); }
+    else if constexpr (n == 11) { auto& [a, b, c, d, e, g, h, i, j, k, l] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); }
+    else if constexpr (n == 12) { auto& [a, b, c, d, e, g, h, i, j, k, l, m] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m); }
+    else if constexpr (n == 13) { auto& [a, b, c, d, e, g, h, i, j, k, l, m, o] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m); f(o); }
+    else if constexpr (n == 14) { auto& [a, b, c, d, e, g, h, i, j, k, l, m, o, p] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m); f(o); f(p); }
+    else if constexpr (n == 15) { auto& [a, b, c, d, e, g, h, i, j, k, l, m, o, p, q] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m); f(o); f(p); f(q); }
+    else if constexpr (n == 16) { auto& [a, b, c, d, e, g, h, i, j, k, l, m, o, p, q, r] = t; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m); f(o); f(p); f(q); f(r); }
+}
+
+template<typename T>
+struct is_std_array : std::false_type {};
+
+template<typename T, size_t N>
+struct is_std_array<std::array<T, N>> : std::true_type {};
+
+template<typename T>
+constexpr bool is_reflected_aggregate = std::is_class<T>::value && std::is_aggregate<T>::value && !is_std_array<T>::value;
+
+}
+
+template<typename DataStream, typename T, std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
+DataStream& operator<<(DataStream& ds, const T& value) {
+    ds.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    return ds;
+}
+
+template<typename DataStream, typename T, std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
+DataStream& operator>>(DataStream& ds, T& value) {
+    ds.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return ds;
+}
+
+template<typename DataStream>
+DataStream& operator<<(DataStream& ds, const name& value) { return ds << value.value; }
+
+template<typename DataStream>
+DataStream& operator>>(DataStream& ds, name& value) { return ds >> value.value; }
+
+template<typename DataStream>
+DataStream& operator<<(DataStream& ds, const symbol_code& value) { return ds << value.raw(); }
+
+template<typename DataStream>
+DataStream& operator>>(DataStream& ds, symbol_code& value) {
+    uint64_t raw;
+    ds >> raw;
+    value = symbol_code(raw);
+    return ds;
+}
+
+template<typename DataStream>
+DataStream& operator<<(DataStream& ds, const symbol& value) { return ds << value.raw(); }
+
+template<typename DataStream>
+DataStream& operator>>(DataStream& ds, symbol& value) {
+    uint64_t raw;
+    ds >> raw;
+    value = symbol(raw);
+    return ds;
+}
+
+template<typename DataStream>
+DataStream& operator<<(DataStream& ds, const asset& value) { return ds << value.amount << value.symbol; }
+
+template<typename DataStream>
+DataStream& operator>>(DataStream& ds, asset& value) { return ds >> value.amount >> value.symbol; }
+
+// lengths are written as varuint32
+template<typename DataStream>
+void write_length(DataStream& ds, uint64_t length) {
+    do {
+        uint8_t byte = length & 0x7f;
+        length >>= 7;
+        byte |= (length > 0) << 7;
+        ds.write(reinterpret_cast<const char*>(&byte), 1);
+    } while (length);
+}
+
+template<typename DataStream>
+uint32_t read_length(DataStream& ds) {
+    uint64_t length = 0;
+    uint8_t byte;
+    uint8_t shift = 0;
+    do {
+        ds.read(reinterpret_cast<char*>(&byte), 1);
+        length |= uint64_t(byte & 0x7f) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && shift < 35);
+    return uint32_t(length);
+}
+
+template<typename DataStream>
+DataStream& operator<<(DataStream& ds, const std::string& value) {
+    write_length(ds, value.size());
+    if (!value.empty())
+        ds.write(value.data(), value.size());
+    return ds;
+}
+
+template<typename DataStream>
+DataStream& operator>>(DataStream& ds, std::string& value) {
+    uint32_t length = read_length(ds);
+    eosio_assert(length <= ds.remaining(), "datastream attempted to read past the end");
+    value.assign(ds.pos(), length);
+    ds.skip(length);
+    return ds;
+}
+
+template<typename DataStream, typename T>
+DataStream& operator<<(DataStream& ds, const std::vector<T>& value) {
+    write_length(ds, value.size());
+    for (const auto& item : value)
+        ds << item;
+    return ds;
+}
+
+template<typename DataStream, typename T>
+DataStream& operator>>(DataStream& ds, std::vector<T>& value) {
+    uint32_t length = read_length(ds);
+    eosio_assert(length <= ds.remaining(), "datastream attempted to read past the end");
+    value.resize(length);
+    for (auto& item : value)
+        ds >> item;
+    return ds;
+}
+
+template<typename DataStream, typename T, size_t N>
+DataStream& operator<<(DataStream& ds, const std::array<T, N>& value) {
+    for (const auto& item : value)
+        ds << item;
+    return ds;
+}
+
+template<typename DataStream, typename T, size_t N>
+DataStream& operator>>(DataStream& ds, std::array<T, N>& value) {
+    for (auto& item : value)
+        ds >> item;
+    return ds;
+}
+
+namespace native {
+
+template<typename DataStream, typename Tuple, size_t... I>
+void write_tuple(DataStream& ds, const Tuple& value, std::index_sequence<I...>) {
+    (void)std::initializer_list<int>{ ((ds << std::get<I>(value)), 0)... };
+}
+
+template<typename DataStream, typename Tuple, size_t... I>
+void read_tuple(DataStream& ds, Tuple& value, std::index_sequence<I...>) {
+    (void)std::initializer_list<int>{ ((ds >> std::get<I>(value)), 0)... };
+}
+
+}
+
+template<typename DataStream, typename... Args>
+DataStream& operator<<(DataStream& ds, const std::tuple<Args...>& value) {
+    native::write_tuple(ds, value, std::index_sequence_for<Args...>());
+    return ds;
+}
+
+template<typename DataStream, typename... Args>
+DataStream& operator>>(DataStream& ds, std::tuple<Args...>& value) {
+    native::read_tuple(ds, value, std::index_sequence_for<Args...>());
+    return ds;
+}
+
+template<typename DataStream, typename T, std::enable_if_t<native::is_reflected_aggregate<T>, int> = 0>
+DataStream& operator<<(DataStream& ds, const T& value) {
+    native::for_each_field(value, [&](const auto& field) { ds << field; });
+    return ds;
+}
+
+template<typename DataStream, typename T, std::enable_if_t<native::is_reflected_aggregate<T>, int> = 0>
+DataStream& operator>>(DataStream& ds, T& value) {
+    native::for_each_field(value, [&](auto& field) { ds >> field; });
+    return ds;
+}
+
+template<typename T>
+size_t pack_size(const T& value) {
+    datastream<size_t> ds;
+    ds << value;
+    return ds.tellp();
+}
+
+template<typename T>
+std::vector<char> pack(const T& value) {
+    std::vector<char> res(pack_size(value));
+    datastream<const char*> ds(res.data(), res.size());
+    ds << value;
+    return res;
+}
+
+template<typename T>
+T unpack(const char* data, size_t size) {
+    T res;
+    datastream<const char*> ds(data, size);
+    ds >> res;
+    return res;
+}
+
+template<typename T>
+T unpack(const std::vector<char>& data) {
+    return unpack<T>(data.data(), data.size());
+}
+
+}
+
+// serializes the listed members, in order
+#define EOSLIB_SERIALIZE_OUT_A(member) << t.member EOSLIB_SERIALIZE_OUT_B
+#define EOSLIB_SERIALIZE_OUT_B(member) << t.member EOSLIB_SERIALIZE_OUT_A
+#define EOSLIB_SERIALIZE_OUT_A_END
+#define EOSLIB_SERIALIZE_OUT_B_END
+#define EOSLIB_SERIALIZE_IN_A(member) >> t.member EOSLIB_SERIALIZE_IN_B
+#define EOSLIB_SERIALIZE_IN_B(member) >> t.member EOSLIB_SERIALIZE_IN_A
+#define EOSLIB_SERIALIZE_IN_A_END
+#define EOSLIB_SERIALIZE_IN_B_END
+#define EOSLIB_SERIALIZE_CAT(a, b) EOSLIB_SERIALIZE_CAT_I(a, b)
+#define EOSLIB_SERIALIZE_CAT_I(a, b) a ## b
+
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS) \
+    template<typename DataStream> \
+    friend DataStream& operator<<(DataStream& ds, const TYPE& t) { \
+        return ds EOSLIB_SERIALIZE_CAT(EOSLIB_SERIALIZE_OUT_A MEMBERS, _END); \
+    } \
+    template<typename DataStream> \
+    friend DataStream& operator>>(DataStream& ds, TYPE& t) { \
+        return ds EOSLIB_SERIALIZE_CAT(EOSLIB_SERIALIZE_IN_A MEMBERS, _END); \
+    }
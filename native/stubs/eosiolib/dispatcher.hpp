@@ -0,0 +1,64 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "action.hpp"
+
+namespace eosio {
+
+namespace native {
+
+template<typename T, typename Method, typename Tuple, size_t... I>
+void call_with_tuple(T& obj, Method method, Tuple& args, std::index_sequence<I...>) {
+    (obj.*method)(std::get<I>(args)...);
+}
+
+}
+
+// deserializes the action data into the method arguments and calls it on a new contract instance
+template<typename T, typename... Args>
+bool execute_action(name self, name code, void (T::*func)(Args...)) {
+    const auto& data = native::current_host().action_data();
+    datastream<const char*> ds(data.data(), data.size());
+
+    std::tuple<std::decay_t<Args>...> args;
+    ds >> args;
+
+    T inst(self, code, ds);
+    native::call_with_tuple(inst, func, args, std::index_sequence_for<Args...>());
+    return true;
+}
+
+}
+
+#define EOSIO_DISPATCH_CASE_A(member) \
+    case eosio::name(#member).value: \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &eosio_dispatch_type::member); \
+        break; \
+    EOSIO_DISPATCH_CASE_B
+#define EOSIO_DISPATCH_CASE_B(member) \
+    case eosio::name(#member).value: \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &eosio_dispatch_type::member); \
+        break; \
+    EOSIO_DISPATCH_CASE_A
+#define EOSIO_DISPATCH_CASE_A_END
+#define EOSIO_DISPATCH_CASE_B_END
+#define EOSIO_DISPATCH_CAT(a, b) EOSIO_DISPATCH_CAT_I(a, b)
+#define EOSIO_DISPATCH_CAT_I(a, b) a ## b
+
+// the cases of a switch on the action name, for the listed actions of TYPE
+#define EOSIO_DISPATCH_HELPER(TYPE, MEMBERS) \
+    using eosio_dispatch_type = TYPE; \
+    EOSIO_DISPATCH_CAT(EOSIO_DISPATCH_CASE_A MEMBERS, _END)
+
+#define EOSIO_DISPATCH(TYPE, MEMBERS) \
+    extern "C" { \
+        void apply(uint64_t receiver, uint64_t code, uint64_t action) { \
+            if (code == receiver) { \
+                switch (action) { \
+                    EOSIO_DISPATCH_HELPER(TYPE, MEMBERS) \
+                } \
+            } \
+        } \
+    }
@@ -0,0 +1,22 @@
+#pragma once
+
+/*
+    Host versions of the eosio.cdt headers the contracts depend on.
+
+    The types and serialization work on their own, so the Common headers can be built and
+    benchmarked natively. The intrinsics and tables call the active host (see host.hpp),
+    which native/sim provides to run the contracts in process.
+    eosio_assert throws std::runtime_error and printed output goes to the console of the
+    executing action, if any.
+*/
+
+#include "system.h"
+#include "print.h"
+#include "name.hpp"
+#include "symbol.hpp"
+#include "asset.hpp"
+#include "datastream.hpp"
+#include "action.hpp"
+#include "contract.hpp"
+#include "dispatcher.hpp"
+#include "multi_index.hpp"
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+
+/*
+    The interface between the host eosio headers and the chain running the contracts.
+
+    The intrinsics (auth, notifications, inline actions, time) and the multi_index emulation
+    call the active host, native/sim/chain.hpp implements it.
+    Accounts and table names are passed as raw name values, rows as serialized data,
+    the same way the contracts exchange them with nodeos.
+*/
+
+namespace eosio {
+
+struct action;
+
+namespace native {
+
+// identifies a contract table - the contract account, scope and table name
+struct table_id {
+    uint64_t code;
+    uint64_t scope;
+    uint64_t table;
+
+    friend bool operator<(const table_id& a, const table_id& b) {
+        if (a.code != b.code) return a.code < b.code;
+        if (a.scope != b.scope) return a.scope < b.scope;
+        return a.table < b.table;
+    }
+    friend bool operator==(const table_id& a, const table_id& b) { return a.code == b.code && a.scope == b.scope && a.table == b.table; }
+};
+
+// a table row, data is the serialized row
+struct db_row {
+    std::vector<char>     data;
+    uint64_t              payer = 0;
+    std::vector<uint64_t> secondary;    // the row's key in each secondary index of the table, in index order
+};
+
+// thrown by eosio_exit, ends the action without an error
+struct action_exit {
+    int32_t code;
+};
+
+class host {
+    public:
+        virtual ~host() = default;
+
+        // the executing action
+        virtual uint64_t current_receiver() = 0;
+        virtual const std::vector<char>& action_data() = 0;
+        virtual bool has_auth(uint64_t account) = 0;
+        virtual void require_recipient(uint64_t account) = 0;
+        virtual void send_inline(const eosio::action& act) = 0;
+
+        virtual bool is_account(uint64_t account) = 0;
+        virtual uint64_t current_time() = 0;  // block time, in microseconds
+
+        // tables, rows are looked up by primary key
+        // lower_bound finds the first row with a key >= primary, last finds the row with the highest key
+        virtual const db_row* db_find(const table_id& table, uint64_t primary) = 0;
+        virtual bool db_lower_bound(const table_id& table, uint64_t primary, uint64_t& found) = 0;
+        virtual bool db_last(const table_id& table, uint64_t& found) = 0;
+        virtual void db_store(const table_id& table, uint64_t primary, db_row row) = 0;  // inserts or replaces a row
+        virtual void db_remove(const table_id& table, uint64_t primary) = 0;
+
+        // secondary indexes, ordered by secondary key and then by primary key
+        // finds the first entry of the index that isn't lower than (secondary, primary)
+        virtual bool db_idx_lower_bound(const table_id& table, size_t index, uint64_t secondary, uint64_t primary,
+                                        uint64_t& found_secondary, uint64_t& found_primary) = 0;
+};
+
+// the chain the contracts currently run on
+inline host*& active_host() {
+    static host* current = nullptr;
+    return current;
+}
+
+inline host& current_host() {
+    host* current = active_host();
+    if (!current)
+        throw std::runtime_error("no active chain");
+    return *current;
+}
+
+}
+}
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "action.hpp"
+
+/*
+    multi_index on top of the host tables.
+
+    Like the eosio.cdt version, every instance caches the rows it loads, so references and
+    iterators stay valid until the row is erased through the same instance, and rows modified
+    through one instance aren't seen by other instances that already loaded them.
+    Secondary indexes are limited to uint64_t keys.
+*/
+
+namespace eosio {
+
+constexpr name same_payer{};
+
+template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+struct const_mem_fun {
+    typedef typename std::remove_reference<Type>::type result_type;
+
+    Type operator()(const Class& x) const { return (x.*PtrToMemberFunction)(); }
+};
+
+template<name::raw IndexName, typename Extractor>
+struct indexed_by {
+    static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+    typedef Extractor secondary_extractor_type;
+};
+
+template<name::raw TableName, typename T, typename... Indices>
+class multi_index {
+    public:
+        class const_iterator {
+            public:
+                const_iterator() = default;
+
+                const T& operator*() const { return *_item; }
+                const T* operator->() const { return _item; }
+
+                const_iterator& operator++() {
+                    eosio_assert(_item != nullptr, "cannot increment end iterator");
+                    uint64_t primary = _item->primary_key();
+                    _item = primary == UINT64_MAX ? nullptr : _multidx->load_lower_bound(primary + 1);
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator res = *this;
+                    ++(*this);
+                    return res;
+                }
+
+                friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._item == b._item; }
+                friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._item != b._item; }
+
+            private:
+                friend class multi_index;
+
+                const_iterator(const multi_index* multidx, const T* item) : _multidx(multidx), _item(item) {}
+
+                const multi_index* _multidx = nullptr;
+                const T*           _item = nullptr;   // null at the end
+        };
+
+        // a secondary index, Number is the position of the index in the table definition
+        template<uint64_t IndexName, typename Extractor, size_t Number>
+        class index {
+            public:
+                typedef typename Extractor::result_type secondary_key_type;
+                static_assert(std::is_same<std::decay_t<secondary_key_type>, uint64_t>::value, "only uint64_t secondary keys are supported");
+
+                class const_iterator {
+                    public:
+                        const_iterator() = default;
+
+                        const T& operator*() const { return *_item; }
+                        const T* operator->() const { return _item; }
+
+                        const_iterator& operator++() {
+                            eosio_assert(_item != nullptr, "cannot increment end iterator");
+                            uint64_t primary = _item->primary_key();
+                            if (primary != UINT64_MAX)
+                                *this = _idx->lower_bound(_secondary, primary + 1);
+                            else if (_secondary != UINT64_MAX)
+                                *this = _idx->lower_bound(_secondary + 1, 0);
+                            else
+                                *this = _idx->end();
+                            return *this;
+                        }
+
+                        const_iterator operator++(int) {
+                            const_iterator res = *this;
+                            ++(*this);
+                            return res;
+                        }
+
+                        friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._item == b._item; }
+                        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._item != b._item; }
+
+                    private:
+                        friend class index;
+
+                        const_iterator(const index* idx, uint64_t secondary, const T* item) : _idx(idx), _secondary(secondary), _item(item) {}
+
+                        const index* _idx = nullptr;
+                        uint64_t     _secondary = 0;
+                        const T*     _item = nullptr;
+                };
+
+                const_iterator begin() const { return lower_bound(0, 0); }
+                const_iterator end() const { return const_iterator(this, 0, nullptr); }
+
+                const_iterator lower_bound(uint64_t secondary) const { return lower_bound(secondary, 0); }
+
+                const_iterator upper_bound(uint64_t secondary) const {
+                    return secondary == UINT64_MAX ? end() : lower_bound(secondary + 1, 0);
+                }
+
+                const_iterator find(uint64_t secondary) const {
+                    auto itr = lower_bound(secondary);
+                    return itr != end() && itr._secondary == secondary ? itr : end();
+                }
+
+                const T& get(uint64_t secondary, const char* error_msg = "unable to find secondary key") const {
+                    auto itr = find(secondary);
+                    eosio_assert(itr != end(), error_msg);
+                    return *itr;
+                }
+
+                const_iterator iterator_to(const T& obj) const {
+                    return const_iterator(this, Extractor()(obj), &obj);
+                }
+
+                template<typename Lambda>
+                void modify(const_iterator itr, name payer, Lambda&& updater) {
+                    eosio_assert(itr != end(), "cannot pass end iterator to modify");
+                    _multidx->modify(*itr, payer, std::forward<Lambda>(updater));
+                }
+
+                // returns the next entry of the index
+                const_iterator erase(const_iterator itr) {
+                    eosio_assert(itr != end(), "cannot pass end iterator to erase");
+                    const_iterator next = itr;
+                    ++next;
+                    // the next entry is loaded before the erase, so it's found by its primary key again
+                    uint64_t next_secondary = next._secondary;
+                    const T* next_item = next._item;
+                    _multidx->erase(*itr);
+                    return const_iterator(this, next_secondary, next_item);
+                }
+
+            private:
+                friend class multi_index;
+
+                explicit index(multi_index* multidx) : _multidx(multidx) {}
+
+                const_iterator lower_bound(uint64_t secondary, uint64_t primary) const {
+                    uint64_t found_secondary, found_primary;
+                    if (!native::current_host().db_idx_lower_bound(_multidx->table(), Number, secondary, primary, found_secondary, found_primary))
+                        return end();
+                    return const_iterator(this, found_secondary, _multidx->load(found_primary));
+                }
+
+                multi_index* _multidx;
+        };
+
+        multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+        // rows are cached by their primary key and owned by the instance
+        multi_index(const multi_index&) = delete;
+        multi_index& operator=(const multi_index&) = delete;
+
+        name get_code() const { return _code; }
+        uint64_t get_scope() const { return _scope; }
+
+        const_iterator begin() const { return const_iterator(this, load_lower_bound(0)); }
+        const_iterator end() const { return const_iterator(this, nullptr); }
+
+        const_iterator find(uint64_t primary) const { return const_iterator(this, load(primary)); }
+        const_iterator lower_bound(uint64_t primary) const { return const_iterator(this, load_lower_bound(primary)); }
+        const_iterator upper_bound(uint64_t primary) const {
+            return primary == UINT64_MAX ? end() : const_iterator(this, load_lower_bound(primary + 1));
+        }
+
+        const_iterator iterator_to(const T& obj) const { return const_iterator(this, &obj); }
+
+        const T& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+            const T* item = load(primary);
+            eosio_assert(item != nullptr, error_msg);
+            return *item;
+        }
+
+        uint64_t available_primary_key() const {
+            uint64_t last;
+            if (!native::current_host().db_last(table(), last))
+                return 0;
+            eosio_assert(last < UINT64_MAX - 1, "next primary key in table is at autoincrement limit");
+            return last + 1;
+        }
+
+        template<typename Lambda>
+        const_iterator emplace(name payer, Lambda&& constructor) {
+            eosio_assert(_code == current_receiver(), "cannot create objects in table of another contract");
+
+            auto item = std::make_unique<T>();
+            constructor(*item);
+            uint64_t primary = item->primary_key();
+            eosio_assert(_items.find(primary) == _items.end() && !native::current_host().db_find(table(), primary),
+                         "could not insert object, most likely a uniqueness constraint was violated");
+
+            store(*item, payer.value);
+            const T* res = item.get();
+            _items.emplace(primary, std::move(item));
+            return const_iterator(this, res);
+        }
+
+        template<typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda&& updater) {
+            eosio_assert(itr != end(), "cannot pass end iterator to modify");
+            modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        template<typename Lambda>
+        void modify(const T& obj, name payer, Lambda&& updater) {
+            eosio_assert(_code == current_receiver(), "cannot modify objects in table of another contract");
+            uint64_t primary = obj.primary_key();
+            auto cached = _items.find(primary);
+            eosio_assert(cached != _items.end() && cached->second.get() == &obj, "object passed to modify is not in multi_index");
+
+            T& mutable_obj = const_cast<T&>(obj);
+            updater(mutable_obj);
+            eosio_assert(primary == mutable_obj.primary_key(), "updater cannot change primary key when modifying an object");
+
+            const native::db_row* row = native::current_host().db_find(table(), primary);
+            eosio_assert(row != nullptr, "object passed to modify is not in multi_index");
+            store(mutable_obj, payer == same_payer ? row->payer : payer.value);
+        }
+
+        // returns the next row
+        const_iterator erase(const_iterator itr) {
+            eosio_assert(itr != end(), "cannot pass end iterator to erase");
+            const_iterator next = itr;
+            ++next;
+            erase(*itr);
+            return next;
+        }
+
+        void erase(const T& obj) {
+            eosio_assert(_code == current_receiver(), "cannot erase objects in table of another contract");
+            uint64_t primary = obj.primary_key();
+            auto cached = _items.find(primary);
+            eosio_assert(cached != _items.end() && cached->second.get() == &obj, "object passed to erase is not in multi_index");
+
+            native::current_host().db_remove(table(), primary);
+            _items.erase(cached);
+        }
+
+        template<name::raw IndexName>
+        auto get_index() {
+            constexpr size_t number = index_number<static_cast<uint64_t>(IndexName), Indices...>();
+            static_assert(number < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+            using index_type = typename std::tuple_element<number, std::tuple<Indices...>>::type;
+            return index<static_cast<uint64_t>(IndexName), typename index_type::secondary_extractor_type, number>(this);
+        }
+
+        template<name::raw IndexName>
+        auto get_index() const {
+            return const_cast<multi_index*>(this)->template get_index<IndexName>();
+        }
+
+    private:
+        name     _code;
+        uint64_t _scope;
+        mutable std::map<uint64_t, std::unique_ptr<T>> _items;
+
+        template<uint64_t IndexName>
+        static constexpr size_t index_number() { return 0; }
+
+        template<uint64_t IndexName, typename Index, typename... Rest>
+        static constexpr size_t index_number() {
+            return Index::index_name == IndexName ? 0 : 1 + index_number<IndexName, Rest...>();
+        }
+
+        native::table_id table() const {
+            return { _code.value, _scope, static_cast<uint64_t>(TableName) };
+        }
+
+        // returns the cached row, or loads it from the table, null if it doesn't exist
+        const T* load(uint64_t primary) const {
+            auto cached = _items.find(primary);
+            if (cached != _items.end())
+                return cached->second.get();
+
+            const native::db_row* row = native::current_host().db_find(table(), primary);
+            if (!row)
+                return nullptr;
+
+            auto item = std::make_unique<T>();
+            datastream<const char*> ds(row->data.data(), row->data.size());
+            ds >> *item;
+            const T* res = item.get();
+            _items.emplace(primary, std::move(item));
+            return res;
+        }
+
+        const T* load_lower_bound(uint64_t primary) const {
+            uint64_t found;
+            return native::current_host().db_lower_bound(table(), primary, found) ? load(found) : nullptr;
+        }
+
+        void store(const T& obj, uint64_t payer) {
+            native::db_row row;
+            row.data = pack(obj);
+            row.payer = payer;
+            row.secondary = { typename Indices::secondary_extractor_type()(obj)... };
+            native::current_host().db_store(table(), obj.primary_key(), std::move(row));
+        }
+};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "system.h"
+
+namespace eosio {
+
+struct name {
+    // the raw value, usable as a template argument, e.g. multi_index<"accounts"_n, account>
+    enum class raw : uint64_t {};
+
+    uint64_t value = 0;
+
+    constexpr name() = default;
+    constexpr explicit name(uint64_t v) : value(v) {}
+    constexpr name(raw r) : value(static_cast<uint64_t>(r)) {}
+
+    constexpr explicit name(std::string_view str) {
+        if (str.size() > 13)
+            eosio_assert(false, "string is too long to be a valid name");
+
+        size_t n = str.size() < 12 ? str.size() : 12;
+        for (size_t i = 0; i < n; ++i) {
+            value <<= 5;
+            value |= char_to_value(str[i]);
+        }
+        value <<= 4 + 5 * (12 - n);
+        if (str.size() == 13)
+            value |= char_to_value(str[12]);
+    }
+
+    static constexpr uint8_t char_to_value(char c) {
+        if (c == '.')
+            return 0;
+        if (c >= '1' && c <= '5')
+            return (c - '1') + 1;
+        if (c >= 'a' && c <= 'z')
+            return (c - 'a') + 6;
+        eosio_assert(false, "character is not in allowed character set for names");
+        return 0;
+    }
+
+    std::string to_string() const {
+        static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+        std::string str(13, '.');
+        uint64_t tmp = value;
+        for (uint32_t i = 0; i <= 12; ++i) {
+            str[12 - i] = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+            tmp >>= (i == 0 ? 4 : 5);
+        }
+        size_t end = str.find_last_not_of('.');
+        str.resize(end == std::string::npos ? 0 : end + 1);
+        return str;
+    }
+
+    constexpr operator raw() const { return raw(value); }
+    constexpr explicit operator bool() const { return value != 0; }
+    friend constexpr bool operator==(const name& a, const name& b) { return a.value == b.value; }
+    friend constexpr bool operator!=(const name& a, const name& b) { return a.value != b.value; }
+    friend constexpr bool operator<(const name& a, const name& b) { return a.value < b.value; }
+};
+
+}
+
+template <typename T, T... Str>
+inline constexpr eosio::name operator""_n() {
+    constexpr char str[] = { Str..., 0 };
+    return eosio::name(std::string_view(str, sizeof...(Str)));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+
+// printed output is counted and only kept when a console is set, benchmarks shouldn't measure the terminal
+inline uint64_t& printed_bytes() {
+    static uint64_t count = 0;
+    return count;
+}
+
+// the console of the executing action, set by the simulator
+inline std::string*& print_console() {
+    static std::string* console = nullptr;
+    return console;
+}
+
+inline void prints_l(const char* s, uint32_t len) {
+    printed_bytes() += len;
+    if (std::string* console = print_console())
+        console->append(s, len);
+}
+
+inline void prints(const char* s) {
+    uint32_t len = 0;
+    while (s[len])
+        ++len;
+    prints_l(s, len);
+}
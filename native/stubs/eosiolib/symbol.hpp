@@ -0,0 +1,74 @@
+#pragma once
+
+#include "name.hpp"
+
+namespace eosio {
+
+class symbol_code {
+    public:
+        constexpr symbol_code() = default;
+        constexpr explicit symbol_code(uint64_t raw) : value(raw) {}
+
+        constexpr explicit symbol_code(std::string_view str) {
+            if (str.size() > 7)
+                eosio_assert(false, "string is too long to be a valid symbol_code");
+            for (auto itr = str.rbegin(); itr != str.rend(); ++itr) {
+                if (*itr < 'A' || *itr > 'Z')
+                    eosio_assert(false, "only uppercase letters allowed in symbol_code string");
+                value <<= 8;
+                value |= *itr;
+            }
+        }
+
+        constexpr bool is_valid() const {
+            uint64_t sym = value;
+            if (sym == 0)
+                return false;
+            for (; sym & 0xFF; sym >>= 8) {
+                char c = char(sym & 0xFF);
+                if (c < 'A' || c > 'Z')
+                    return false;
+            }
+            return sym == 0;
+        }
+
+        constexpr uint64_t raw() const { return value; }
+        constexpr explicit operator bool() const { return value != 0; }
+
+        std::string to_string() const {
+            std::string str;
+            for (uint64_t sym = value; sym; sym >>= 8)
+                str += char(sym & 0xFF);
+            return str;
+        }
+
+        friend constexpr bool operator==(const symbol_code& a, const symbol_code& b) { return a.value == b.value; }
+        friend constexpr bool operator!=(const symbol_code& a, const symbol_code& b) { return a.value != b.value; }
+        friend constexpr bool operator<(const symbol_code& a, const symbol_code& b) { return a.value < b.value; }
+
+    private:
+        uint64_t value = 0;
+};
+
+class symbol {
+    public:
+        constexpr symbol() = default;
+        constexpr explicit symbol(uint64_t raw) : value(raw) {}
+        constexpr symbol(symbol_code code, uint8_t precision) : value((code.raw() << 8) | precision) {}
+        constexpr symbol(std::string_view code, uint8_t precision) : value((symbol_code(code).raw() << 8) | precision) {}
+
+        constexpr bool is_valid() const { return code().is_valid(); }
+        constexpr uint8_t precision() const { return value & 0xFF; }
+        constexpr symbol_code code() const { return symbol_code(value >> 8); }
+        constexpr uint64_t raw() const { return value; }
+        constexpr explicit operator bool() const { return value != 0; }
+
+        friend constexpr bool operator==(const symbol& a, const symbol& b) { return a.value == b.value; }
+        friend constexpr bool operator!=(const symbol& a, const symbol& b) { return a.value != b.value; }
+        friend constexpr bool operator<(const symbol& a, const symbol& b) { return a.value < b.value; }
+
+    private:
+        uint64_t value = 0;
+};
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdexcept>
+
+#include "host.hpp"
+
+// failed assertions throw, so native code can test the rejected inputs
+inline void eosio_assert(uint32_t test, const char* msg) {
+    if (!test)
+        throw std::runtime_error(msg);
+}
+
+// ends the action successfully
+[[noreturn]] inline void eosio_exit(int32_t code) {
+    throw eosio::native::action_exit{ code };
+}
+
+// the current block time, in microseconds
+inline uint64_t current_time() {
+    return eosio::native::current_host().current_time();
+}
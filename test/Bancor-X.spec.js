@@ -35,6 +35,19 @@ describe('BancorX Contract', () => {
 
     });
 
+    it('should throw when calling xTransfer without a target', async function() {
+        const token = await getEos(testUser).contract(networkToken);
+        const p = token.transfer({
+            from: testUser,
+            to: bancorXContract,
+            quantity: `1.0000000000 ${networkTokenSymbol}`,
+            memo: 'hello'
+        }, {
+            authorization: [`${testUser}@active`]
+        });
+        await ensureContractAssertionError(p, ERRORS.INVALID_MEMO);
+    });
+
     it('should throw when calling xTransfer with wrong permissions', async function() {
         let pass = false
         const token = await getEos(testUser).contract(networkToken);
@@ -134,13 +147,17 @@ describe('BancorX Contract', () => {
         });
 
         transfers.rows[0].tx_id.should.be.equal(transferId);
-        transfers.rows[0].target.should.be.equal('test1');
-        transfers.rows[0].quantity.should.be.equal('2.0000000000 BNT');
-        transfers.rows[0].blockchain.should.be.equal('eth');
-        transfers.rows[0].memo.should.be.equal('text');
-        transfers.rows[0].data.should.be.equal('txHash');
-        transfers.rows[0]['x_transfer_id'].should.be.equal(0);
-        transfers.rows[0].reporters.should.include('reporter1');
+        transfers.rows[0].payload_hash.should.match(/^[0-9a-f]{64}$/);
+        transfers.rows[0].reporters_count.should.be.equal(1);
+
+        const reporters = await getEos(bancorXContract).getTableRows({
+            code: bancorXContract,
+            scope: bancorXContract,
+            table: 'reporters',
+            json: true
+        });
+        const { index } = reporters.rows.find(row => row.reporter === reporter1User);
+        ((Number(transfers.rows[0].reporters) >> index) & 1).should.be.equal(1);
         let balance = await getEos(networkToken).getTableRows({
             code: networkToken,
             scope: testUser,
@@ -184,6 +201,143 @@ describe('BancorX Contract', () => {
 
     })
 
+    it('should issue BNT after a single report signed by 2 reporters', async () => {
+        const banx = await getEos([reporter1User, reporter2User]).contract(bancorXContract);
+        const getBalance = async () => {
+            const balance = await getEos(networkToken).getTableRows({
+                code: networkToken,
+                scope: testUser,
+                table: 'accounts',
+                json: true,
+            });
+            return balance.rows[0].balance;
+        };
+        const prevBalance = await getBalance();
+
+        await banx.reportmulti({
+            reporters: [reporter1User, reporter2User],
+            blockchain: 'eth',
+            tx_id: `${transferId + 1}`,
+            x_transfer_id: '0',
+            target: testUser,
+            quantity: `2.0000000000 ${networkTokenSymbol}`,
+            memo: 'text',
+            data: 'txHash'
+        }, {
+            authorization: [`${reporter1User}@active`, `${reporter2User}@active`]
+        });
+
+        const currBalance = await getBalance();
+        (parseFloat(currBalance) - parseFloat(prevBalance)).should.be.equal(2);
+
+        const transfers = await getEos(bancorXContract).getTableRows({
+            code: bancorXContract,
+            scope: bancorXContract,
+            table: 'transfers',
+            json: true,
+            lower_bound: transferId + 1,
+            limit: 1
+        });
+        transfers.rows.filter(row => row.tx_id == transferId + 1).length.should.be.equal(0);
+    })
+
+    it('should throw when a reporter listed in a multi reporter report did not sign it', async () => {
+        const banx = await getEos(reporter1User).contract(bancorXContract);
+        const p = banx.reportmulti({
+            reporters: [reporter1User, reporter2User],
+            blockchain: 'eth',
+            tx_id: `${transferId + 2}`,
+            x_transfer_id: '0',
+            target: testUser,
+            quantity: `2.0000000000 ${networkTokenSymbol}`,
+            memo: 'text',
+            data: 'txHash'
+        }, {
+            authorization: [`${reporter1User}@active`]
+        });
+        await ensureContractAssertionError(p, ERRORS.PERMISSIONS);
+    })
+
+    it('should issue every BNT transfer of a batch once it is reported by 2 reporters', async () => {
+        const getBalance = async () => {
+            const balance = await getEos(networkToken).getTableRows({
+                code: networkToken,
+                scope: testUser,
+                table: 'accounts',
+                json: true,
+            });
+            return balance.rows[0].balance;
+        };
+        const prevBalance = await getBalance();
+
+        const reports = [transferId + 3, transferId + 4].map(txId => ({
+            blockchain: 'eth',
+            tx_id: `${txId}`,
+            x_transfer_id: '0',
+            target: testUser,
+            quantity: `1.0000000000 ${networkTokenSymbol}`,
+            memo: 'text',
+            data: 'txHash'
+        }));
+
+        for (const reporter of [reporter1User, reporter2User]) {
+            const banx = await getEos(reporter).contract(bancorXContract);
+            await banx.reportbatch({
+                reporter,
+                reports
+            }, {
+                authorization: [`${reporter}@active`]
+            });
+        }
+
+        const currBalance = await getBalance();
+        (parseFloat(currBalance) - parseFloat(prevBalance)).should.be.equal(2);
+    })
+
+    it('should keep the transfers that did not expire when purging', async () => {
+        const banx = await getEos(reporter1User).contract(bancorXContract);
+        await banx.reporttx({
+            tx_id: `${transferId + 5}`,
+            reporter: reporter1User,
+            target: testUser,
+            quantity: `1.0000000000 ${networkTokenSymbol}`,
+            memo: 'text',
+            data: 'txHash',
+            blockchain: 'eth',
+            x_transfer_id: '0'
+        }, {
+            authorization: [`${reporter1User}@active`]
+        });
+
+        const purger = await getEos(testUser).contract(bancorXContract);
+        await purger.purge({
+            max_rows: 10
+        }, {
+            authorization: [`${testUser}@active`]
+        });
+
+        const transfers = await getEos(bancorXContract).getTableRows({
+            code: bancorXContract,
+            scope: bancorXContract,
+            table: 'transfers',
+            json: true,
+            lower_bound: transferId + 5,
+            limit: 1
+        });
+        transfers.rows[0].tx_id.should.be.equal(transferId + 5);
+        transfers.rows[0].report_time.should.be.above(0);
+    })
+
+    it('should throw when purging 0 rows', async () => {
+        const purger = await getEos(testUser).contract(bancorXContract);
+        const p = purger.purge({
+            max_rows: 0
+        }, {
+            authorization: [`${testUser}@active`]
+        });
+        await ensureContractAssertionError(p, ERRORS.INVALID_MAX_ROWS);
+    })
+
     it('should throw when calling xTransfer with a token other than BNT', async function() {
         const token = await getEos(testUser).contract(networkToken);
         const p = token.transfer({
@@ -1,5 +1,6 @@
 require("babel-core/register");
 require("babel-polyfill");
+const { assert } = require('chai');
 const { ERRORS } = require('./constants');
 
 const {
@@ -87,4 +88,19 @@ describe('BancorConverter', () => {
 
         await ensurePromiseDoesntThrow(p);
     });
+
+    it("verifies the tracked reserve balances and smart supply match the token contracts", async () => {
+        const eos = getEos(testUser);
+        const reserves = await eos.getTableRows({ json: true, code: converterC, scope: converterC, table: 'reserves', limit: 10 });
+        const settings = await eos.getTableRows({ json: true, code: converterC, scope: converterC, table: 'settings', limit: 1 });
+
+        for (const reserve of reserves.rows) {
+            const symbol = reserve.currency.split(' ')[1];
+            const balance = await eos.getCurrencyBalance(reserve.contract, converterC, symbol);
+            assert.equal(reserve.balance, balance[0], `unexpected ${symbol} tracked balance`);
+        }
+
+        const stats = await eos.getCurrencyStats(settings.rows[0].smart_contract, tokenCRelaySymbol);
+        assert.equal(settings.rows[0].smart_supply, stats[tokenCRelaySymbol].supply, "unexpected tracked smart supply");
+    });
 });
\ No newline at end of file
@@ -3,7 +3,7 @@ require("babel-polyfill");
 import Eos from 'eosjs';
 import { assert } from 'chai';
 import 'mocha';
-import { ensureContractAssertionError, getEos } from './utils';
+import { ensureContractAssertionError, getEos, packMemo, getEvents } from './utils';
 import { ERRORS } from './constants';
 const fs = require('fs');
 const path = require('path');
@@ -18,6 +18,7 @@ describe('BancorNetwork Contract', () => {
     const converter = 'cnvtaa';
     const converter2 = 'cnvtbb';
     const networkContract = 'thisisbancor';
+    const bancorXContract = 'bancorxoneos';
     const bntConverter = 'bnt2eoscnvrt';
     const networkTokenSymbol = "BNT";
     const networkToken = 'bnt';
@@ -48,22 +49,203 @@ describe('BancorNetwork Contract', () => {
         var minReturn = 0.100;
         const token = await _self.contract(tokenContract)
         let res = await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: `1,${converter} ${networkTokenSymbol} ${converter2} ${tokenSymbol2},${minReturn},${testUser1}` }, _selfopts);
-        var events = res.processed.action_traces[0].inline_traces[2].inline_traces[1].console.split("\n");
-        console.log(events)
-        let convertEvent = JSON.parse(events[0]);
-        let priceDataEvent = JSON.parse(events[1]);
-        assert.equal(convertEvent.return, 1.0000299998, "unexpected conversion result");
-        assert.equal(priceDataEvent.reserve_ratio, 0.5, "unexpected reserve_ratio");
-        
-        events = res.processed.action_traces[0].inline_traces[2].inline_traces[2].inline_traces[2].inline_traces[1].console.split("\n");
-        console.log(events)
-        convertEvent = JSON.parse(events[0]);
-        priceDataEvent = JSON.parse(events[1]);
-        assert.equal(convertEvent.return, 0.99802094, "unexpected conversion result");
-        assert.equal(convertEvent.conversion_fee, 0.00099951, "unexpected conversion result");
-        assert.equal(priceDataEvent.reserve_ratio, 0.5, "unexpected reserve_ratio");
+        const conversionEvents = getEvents(res, 'conversion');
+        const priceDataEvents = getEvents(res, 'price_data');
+        assert.equal(conversionEvents.length, 2, "unexpected number of conversions");
+        assert.equal(conversionEvents[0].return, 1.0000299998, "unexpected conversion result");
+        assert.equal(priceDataEvents[0].reserve_ratio, 0.5, "unexpected reserve_ratio");
+
+        assert.equal(conversionEvents[1].return, 0.99802095, "unexpected conversion result");
+        assert.equal(conversionEvents[1].conversion_fee, 0.00199904, "unexpected conversion result");
+        assert.equal(priceDataEvents[2].reserve_ratio, 0.5, "unexpected reserve_ratio");
+    });
+
+    it('2 hop convert sends the intermediate return directly to the next converter', async function() {
+        var minReturn = 0.100;
+        const token = await _self.contract(tokenContract)
+        let res = await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: `1,${converter} ${networkTokenSymbol} ${converter2} ${tokenSymbol2},${minReturn},${testUser1}` }, _selfopts);
+        const transfers = [];
+        const collect = trace => {
+            if (trace.act.name === 'transfer' && trace.receipt.receiver === trace.act.account)
+                transfers.push(trace.act.data);
+            trace.inline_traces.forEach(collect);
+        };
+        res.processed.action_traces.forEach(collect);
+
+        assert.deepEqual(transfers.map(t => [t.from, t.to]), [
+            [testUser1, networkContract],
+            [networkContract, converter],
+            [converter, converter2],
+            [converter2, testUser1]
+        ], "unexpected token transfers");
+    });
+
+    it('2 hop convert with a hop cursor memo', async function() {
+        var minReturn = 0.100;
+        const token = await _self.contract(tokenContract)
+        const memo = `1.1,0,${converter} ${networkTokenSymbol} ${converter2} ${tokenSymbol2},${minReturn},${testUser1}`;
+        let res = await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo }, _selfopts);
+        const conversionEvents = getEvents(res, 'conversion');
+        assert.equal(conversionEvents[0].memo, memo, "unexpected first hop memo");
+        assert.equal(conversionEvents[1].memo, `1.1,1,${converter} ${networkTokenSymbol} ${converter2} ${tokenSymbol2},${minReturn},${testUser1}`, "unexpected second hop memo");
+        assert.equal(conversionEvents[1].to_symbol, tokenSymbol2, "unexpected conversion target");
+    });
+
+    it('2 hop convert with a packed memo', async function() {
+        const token = await _self.contract(tokenContract)
+        const memo = packMemo([[converter, networkTokenSymbol], [converter2, tokenSymbol2]], 10000000, testUser1);
+        let res = await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo }, _selfopts);
+        const conversionEvents = getEvents(res, 'conversion');
+        assert.equal(conversionEvents[0].memo, memo, "unexpected first hop memo");
+        assert.equal(conversionEvents[0].to_symbol, networkTokenSymbol, "unexpected conversion target");
+        assert.equal(conversionEvents[1].to_symbol, tokenSymbol2, "unexpected conversion target");
+    });
+
+    it('verifies a packed memo min return is enforced', async function() {
+        const token = await _self.contract(tokenContract)
+        const memo = packMemo([[converter, networkTokenSymbol]], 100000000000000, testUser1);
+        const conversion = token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.BELOW_MIN_RETURN);
+    });
+
+    it('verifies a path with an unknown symbol in a later step is rejected before converting', async function() {
+        const token = await _self.contract(tokenContract)
+        const memo = `1,${converter} ${networkTokenSymbol} ${converter2} TKNX,0.1,${testUser1}`;
+        const conversion = token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.RESERVE_NOT_FOUND);
+    });
+
+    it('verifies a path with the smart token in a middle step is rejected', async function() {
+        const token = await _self.contract(tokenContract)
+        const memo = `1,${converter} ${networkTokenSymbol}${tokenSymbol} ${converter} ${networkTokenSymbol},0.1,${testUser1}`;
+        const conversion = token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.SMART_TOKEN_NOT_FINAL);
+    });
+
+    it('verifies a path with consecutive steps through the same converter is rejected', async function() {
+        const token = await _self.contract(tokenContract)
+        const memo = `1,${converter} ${networkTokenSymbol} ${converter} ${networkTokenSymbol}${tokenSymbol},0.1,${testUser1}`;
+        const conversion = token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.SAME_CONVERTER);
+    });
+
+    it('verifies converters are added to the registry with their reserves', async function() {
+        const res = await _self.getTableRows({ json: true, code: networkContract, scope: networkContract, table: 'converters', lower_bound: converter, limit: 1 });
+        const entry = res.rows[0];
+        assert.equal(entry.converter, converter, "converter not registered");
+        assert.equal(entry.enabled, 1, "unexpected enabled flag");
+        assert.equal(entry.smart_symbol, `${networkTokenSymbol}${tokenSymbol}`, "unexpected smart token symbol");
+        assert.deepEqual(entry.reserves.map(r => r.symbol).sort(), [networkTokenSymbol, tokenSymbol], "unexpected reserves");
+    });
+
+    it("verifies only the network or a registered converter can update a converter's registry entry", async function() {
+        const network = await _self.contract(networkContract);
+        const registration = network.regconverter({ converter }, _selfopts);
+        await ensureContractAssertionError(registration, ERRORS.PERMISSIONS);
+    });
+
+    it('verifies tokens cannot be deposited before the deposit is opened', async function() {
+        const token = await _self.contract(tokenContract)
+        const deposit = token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: 'deposit' }, _selfopts);
+        await ensureContractAssertionError(deposit, ERRORS.DEPOSIT_NOT_OPEN);
+    });
+
+    it('converts deposited tokens in a batch', async function() {
+        const token = await _self.contract(tokenContract)
+        const network = await _self.contract(networkContract)
+        await network.open({ owner: testUser1, contract: tokenContract, symbol: `8,${tokenSymbol}` }, _selfopts);
+        await token.transfer({ from: testUser1, to: networkContract, quantity: `2.00000000 ${tokenSymbol}`, memo: 'deposit' }, _selfopts);
+
+        const res = await network.convertbatch({
+            owner: testUser1,
+            conversions: [
+                { path: `${converter} ${networkTokenSymbol}`, quantity: `1.00000000 ${tokenSymbol}`, min_return: `0.0000000001 ${networkTokenSymbol}`, destination: testUser1 },
+                { path: `${converter} ${networkTokenSymbol} ${converter2} ${tokenSymbol2}`, quantity: `1.00000000 ${tokenSymbol}`, min_return: `0.00000001 ${tokenSymbol2}`, destination: testUser1 }
+            ]
+        }, _selfopts);
+
+        assert.equal(getEvents(res, 'conversion').length, 3, "unexpected number of conversions");
+        const batchEvent = getEvents(res, 'batch_conversion')[0];
+        assert.equal(batchEvent.owner, testUser1, "unexpected batch owner");
+        assert.equal(batchEvent.conversions, 2, "unexpected number of batch conversions");
+
+        const deposits = await _self.getTableRows({ json: true, code: networkContract, scope: testUser1, table: 'deposits' });
+        assert.equal(deposits.rows.length, 1, "empty deposit closed");
+        assert.equal(deposits.rows[0].balance, `0.00000000 ${tokenSymbol}`, "deposit not used");
+    });
+
+    it('verifies a batch conversion fails when the deposit is insufficient', async function() {
+        const token = await _self.contract(tokenContract)
+        const network = await _self.contract(networkContract)
+        await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: 'deposit' }, _selfopts);
+
+        const conversion = network.convertbatch({
+            owner: testUser1,
+            conversions: [
+                { path: `${converter} ${networkTokenSymbol}`, quantity: `2.00000000 ${tokenSymbol}`, min_return: `0.0000000001 ${networkTokenSymbol}`, destination: testUser1 }
+            ]
+        }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.INSUFFICIENT_DEPOSIT);
+
+        await network.withdraw({ owner: testUser1, quantity: `1.00000000 ${tokenSymbol}` }, _selfopts);
+    });
+
+    it('verifies a batch conversion to the BancorX contract account is rejected', async function() {
+        const token = await _self.contract(tokenContract)
+        const network = await _self.contract(networkContract)
+        await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: 'deposit' }, _selfopts);
+
+        const conversion = network.convertbatch({
+            owner: testUser1,
+            conversions: [
+                { path: `${converter} ${networkTokenSymbol}`, quantity: `1.00000000 ${tokenSymbol}`, min_return: `0.0000000001 ${networkTokenSymbol}`, destination: bancorXContract }
+            ]
+        }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.DESTINATION_NOT_OWNER);
+
+        await network.withdraw({ owner: testUser1, quantity: `1.00000000 ${tokenSymbol}` }, _selfopts);
+    });
+
+    it('verifies a batch conversion fails when the minimum return precision is different', async function() {
+        const token = await _self.contract(tokenContract)
+        const network = await _self.contract(networkContract)
+        await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: 'deposit' }, _selfopts);
+
+        const conversion = network.convertbatch({
+            owner: testUser1,
+            conversions: [
+                { path: `${converter} ${networkTokenSymbol}`, quantity: `1.00000000 ${tokenSymbol}`, min_return: `0.000000001 ${networkTokenSymbol}`, destination: testUser1 }
+            ]
+        }, _selfopts);
+        await ensureContractAssertionError(conversion, ERRORS.MIN_RETURN_SYMBOL_MISMATCH);
+
+        await network.withdraw({ owner: testUser1, quantity: `1.00000000 ${tokenSymbol}` }, _selfopts);
+    });
+
+    it('closes an empty deposit', async function() {
+        const network = await _self.contract(networkContract)
+        await network.close({ owner: testUser1, symbol: tokenSymbol }, _selfopts);
+
+        const deposits = await _self.getTableRows({ json: true, code: networkContract, scope: testUser1, table: 'deposits' });
+        assert.equal(deposits.rows.length, 0, "deposit not closed");
     });
 
+    it('quotes the same return a conversion gets', async function() {
+        const token = await _self.contract(tokenContract)
+        const network = await _self.contract(networkContract)
+        const path = `${converter} ${networkTokenSymbol} ${converter2} ${tokenSymbol2}`;
+
+        const quoteRes = await network.quote({ path, quantity: `1.00000000 ${tokenSymbol}` }, _selfopts);
+        const quotes = getEvents(quoteRes, 'quote');
+        assert.equal(quotes.length, 2, "unexpected number of quoted steps");
+
+        const res = await token.transfer({ from: testUser1, to: networkContract, quantity: `1.00000000 ${tokenSymbol}`, memo: `1,${path},0.1,${testUser1}` }, _selfopts);
+        const conversions = getEvents(res, 'conversion');
+        for (let i = 0; i < 2; i++) {
+            assert.equal(quotes[i].return, conversions[i].return, "quoted return doesn't match the conversion");
+            assert.equal(quotes[i].conversion_fee, conversions[i].conversion_fee, "quoted fee doesn't match the conversion");
+        }
+    });
 
     it("verifies it's not possible to do a conversion with a destination wallet that's different than the origin account", async () => {
         const bntToken = await getEos(testUser1).contract(networkToken);
@@ -19,6 +19,16 @@ module.exports = Object.freeze({
         REROUTING_DISABLED: 'transaction rerouting is disabled',
         TOKEN_PURCHASES_DISABLED: "'to' token purchases disabled",
         INVALID_TARGET_ACCOUNT: 'the destination account must by either the sender, or the BancorX contract account',
-        CONVERTER_DOESNT_EXIST: 'converter doesn\'t exist'
+        CONVERTER_DOESNT_EXIST: 'converter doesn\'t exist',
+        BELOW_MIN_RETURN: 'below min return',
+        RESERVE_NOT_FOUND: 'reserve not found',
+        SMART_TOKEN_NOT_FINAL: 'smart token must be final currency',
+        INSUFFICIENT_DEPOSIT: 'insufficient deposit',
+        DEPOSIT_NOT_OPEN: 'deposit isn\'t open',
+        INVALID_MAX_ROWS: 'max rows must be positive',
+        INVALID_MEMO: 'invalid memo format',
+        SAME_CONVERTER: 'consecutive steps cannot use the same converter',
+        DESTINATION_NOT_OWNER: 'the destination account must be the owner',
+        MIN_RETURN_SYMBOL_MISMATCH: 'minimum return symbol mismatch'
     }
 });
\ No newline at end of file
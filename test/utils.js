@@ -4,7 +4,8 @@ const path = require('path');
 import { assert } from 'chai';
 const getKeyFile = account => JSON.parse(fs.readFileSync(path.resolve(process.env.ACCOUNTS_PATH, `${account}.json`)).toString())
 
-const getEos = account => Eos({ httpEndpoint: host(), keyProvider: getKeyFile(account).privateKey })
+// signs with the keys of one account, or of every account in an array
+const getEos = account => Eos({ httpEndpoint: host(), keyProvider: [].concat(account).map(a => getKeyFile(a).privateKey) })
 
 async function ensureContractAssertionError(prom, expected_error) {
     try {
@@ -37,11 +38,70 @@ const host = () => {
 
 const snooze = ms => new Promise(resolve => setTimeout(resolve, ms));
 
+// encodes an account name as 8 little endian bytes
+const nameBytes = name => {
+    const charmap = '.12345abcdefghijklmnopqrstuvwxyz';
+    let bits = '';
+    for (let i = 0; i < 13; i++) {
+        const c = i < name.length ? charmap.indexOf(name[i]) : 0;
+        bits += c.toString(2).padStart(5, '0').slice(i < 12 ? 0 : 1);
+    }
+    const bytes = [];
+    for (let i = 0; i < 8; i++)
+        bytes.unshift(parseInt(bits.substr(i * 8, 8), 2));
+    return bytes;
+};
+
+// encodes a symbol code as 8 little endian bytes
+const symbolCodeBytes = code => {
+    const bytes = [];
+    for (let i = 0; i < 8; i++)
+        bytes.push(i < code.length ? code.charCodeAt(i) : 0);
+    return bytes;
+};
+
+const int64Bytes = value => {
+    const bytes = [];
+    let low = value % 0x100000000;
+    let high = Math.floor(value / 0x100000000);
+    for (let i = 0; i < 4; i++, low = Math.floor(low / 256))
+        bytes.push(low % 256);
+    for (let i = 0; i < 4; i++, high = Math.floor(high / 256))
+        bytes.push(high % 256);
+    return bytes;
+};
+
+// builds a version 2 (packed) conversion memo
+// path is a list of [converter, symbol] pairs, minReturn is in the smallest unit of the target token
+const packMemo = (path, minReturn, destination, receiverMemo) => {
+    let bytes = [0, path.length];
+    for (const [converter, symbol] of path)
+        bytes = bytes.concat(nameBytes(converter), symbolCodeBytes(symbol));
+    bytes = bytes.concat(int64Bytes(minReturn), nameBytes(destination));
+    const memo = `2,${Buffer.from(bytes).toString('base64')}`;
+    return receiverMemo ? `${memo};${receiverMemo}` : memo;
+};
+
+// returns the events printed by a transaction, in execution order, optionally only those of the given type
+const getEvents = (res, etype) => {
+    const events = [];
+    const collect = trace => {
+        for (const line of (trace.console || '').split('\n'))
+            if (line.startsWith('{'))
+                events.push(JSON.parse(line));
+        (trace.inline_traces || []).forEach(collect);
+    };
+    res.processed.action_traces.forEach(collect);
+    return etype ? events.filter(e => e.etype === etype) : events;
+};
+
 module.exports ={
     getEos,
     getKeyFile,
     ensureContractAssertionError,
     ensurePromiseDoesntThrow,
     host,
-    snooze
+    snooze,
+    packMemo,
+    getEvents
 }
\ No newline at end of file